@@ -1,7 +1,5 @@
 #include "Counter.h"
 
-#include "nlohmann/json.hpp"
-
 #include <string>
 
 Counter::Counter(const std::string& vggFilePath, bool isJsCounter, QWidget* parent)
@@ -14,55 +12,43 @@ Counter::Counter(const std::string& vggFilePath, bool isJsCounter, QWidget* pare
     return;
   }
 
-  m_vggContainer.setEventListener(
-    [](
-      std::shared_ptr<VGG::ISdk> vggSdk,
-      std::string                type,
-      std::string                targetId,
-      std::string                targetName)
+  // resolved once, every event then only sends the changed property
+  auto button = m_vggContainer.element("#counterButton");
+  auto count = m_vggContainer.element("#count");
+
+  // matches both the button and its text
+  const auto target = "#counterButton*";
+
+  m_vggContainer.subscribe(
+    "mousedown",
+    target,
+    [button](const QVggEvent&) mutable
     {
-      if (targetName == "#counterButton" || targetName == "#counterButtonText")
-      {
+      // change button background color alpha
+      button.setValue("/style/fills/0/color/alpha", 1.0);
+    });
+
+  m_vggContainer.subscribe(
+    "mouseup",
+    target,
+    [this, button, count](const QVggEvent&) mutable
+    {
+      // both updates show up in the same frame
+      auto transaction = m_vggContainer.transaction();
 
-        if (type == "mousedown")
-        {
-          // change button background color alpha
-          {
-            const auto  id = "#counterButton";
-            const auto& e = vggSdk->getElement(id);
-            auto        j = nlohmann::json::parse(e);
-            j["style"]["fills"][0]["color"]["alpha"] = 1.0;
-            vggSdk->updateElement(id, j.dump());
-          }
-        }
-        else if (type == "mouseup")
-        {
-          // change button background color alpha
-          {
-            const auto  id = "#counterButton";
-            const auto& e = vggSdk->getElement(id);
-            auto        j = nlohmann::json::parse(e);
-            j["style"]["fills"][0]["color"]["alpha"] = 0.5;
-            vggSdk->updateElement(id, j.dump());
-          }
+      // change button background color alpha
+      button.setValue("/style/fills/0/color/alpha", 0.5);
 
-          // update count number
-          {
-            // get count number
-            const auto  id = "#count";
-            const auto& e = vggSdk->getElement(id);
-            const auto& j = nlohmann::json::parse(e);
-            auto        count = std::stoi(j["content"].get<std::string>());
+      // update count number
+      {
+        // get count number
+        auto number = count.toString("/content").toInt();
 
-            // increase
-            ++count;
+        // increase
+        ++number;
 
-            // update count text
-            nlohmann::json patch;
-            patch["content"] = std::to_string(count);
-            vggSdk->updateElement(id, patch.dump());
-          }
-        }
+        // update count text
+        count.setValue("/content", QString::number(number));
       }
     });
 }
@@ -1,10 +1,12 @@
 // #include "mainwindow.h"
 #include "Counter.h"
 
+#include "VggContainer/QVggEnvironment.hpp"
 #include "VggContainer/QVggEventAdapter.hpp"
-#include "VGG/Environment.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
 
 #include <QApplication>
+#include <QStandardPaths>
 
 #include <filesystem>
 #include <iostream>
@@ -14,9 +16,14 @@ int main(int argc, char* argv[])
   namespace fs = std::filesystem;
   std::cout << "Current path is " << fs::current_path() << std::endl;
 
+  // before the application, which may load the GL driver
+  QApplication::setApplicationName("Counter");
+  QVggShaderCache::setDirectory(
+    QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/vgg/shaders");
+
   QApplication a(argc, argv);
 
-  VGG::Environment::setUp();
+  // The JavaScript environment is started by the first loaded document that contains scripts.
   QVggEventAdapter::setup();
   QSurfaceFormat f;
   f.setAlphaBufferSize(8);
@@ -75,6 +82,6 @@ int main(int argc, char* argv[])
   //   widget->move(800, 800);
   // }
 
-  QObject::connect(&a, &QApplication::aboutToQuit, [&]() { VGG::Environment::tearDown(); });
+  QObject::connect(&a, &QApplication::aboutToQuit, [&]() { QVggEnvironment::tearDown(); });
   return a.exec();
 }
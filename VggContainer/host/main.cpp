@@ -0,0 +1,338 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggRemoteProtocol.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+
+#include "VGG/QtContainer.hpp"
+
+#include <QGuiApplication>
+#include <QLocalSocket>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSharedMemory>
+#include <QTimer>
+
+#include <array>
+#include <cstring>
+#include <memory>
+
+// Hosts the container of a QVggRemoteContainer, which starts it with the name of its server and
+// a token that identifies the host to it:
+//   VggRenderHost <server> <token>
+// Frames are rendered offscreen into the shared memory of the application. The host quits when the
+// application closes the connection.
+
+namespace
+{
+
+class RenderHost : public QObject
+{
+public:
+  bool start(const QString& serverName, const QByteArray& token)
+  {
+    if (!m_context.create())
+    {
+      qCritical("VggRenderHost: no OpenGL context");
+      return false;
+    }
+    m_surface.setFormat(m_context.format());
+    m_surface.create();
+    m_context.makeCurrent(&m_surface);
+    QVggShaderCache::validate(&m_context);
+
+    m_container = std::make_unique<VGG::QtContainer>();
+    m_container->setEventListener(
+      [this](std::string type, std::string targetId, std::string targetPath)
+      {
+        send(QVggRemoteProtocol::message(
+          QVggRemoteProtocol::Event,
+          QByteArray::fromStdString(type),
+          QByteArray::fromStdString(targetId),
+          QByteArray::fromStdString(targetPath)));
+      });
+
+    connect(&m_socket, &QLocalSocket::readyRead, this, [this]() { readMessages(); });
+    connect(&m_socket, &QLocalSocket::disconnected, qApp, &QCoreApplication::quit);
+    m_socket.connectToServer(serverName);
+    if (!m_socket.waitForConnected())
+    {
+      qCritical().noquote() << "VggRenderHost: cannot connect," << m_socket.errorString();
+      return false;
+    }
+    send(QVggRemoteProtocol::message(QVggRemoteProtocol::Hello, token));
+
+    m_ticker.setInterval(16);
+    connect(&m_ticker, &QTimer::timeout, this, [this]() { tick(); });
+    m_ticker.start();
+    return true;
+  }
+
+  void stop()
+  {
+    m_ticker.stop();
+    m_context.makeCurrent(&m_surface);
+    m_fbo.reset();
+    m_container.reset();
+    m_context.doneCurrent();
+  }
+
+private:
+  void send(const QByteArray& message)
+  {
+    m_socket.write(message);
+  }
+
+  void readMessages()
+  {
+    m_readBuffer += m_socket.readAll();
+    QByteArray payload;
+    while (QVggRemoteProtocol::takeMessage(m_readBuffer, payload))
+    {
+      handleMessage(payload);
+    }
+  }
+
+  void handleMessage(const QByteArray& payload)
+  {
+    QDataStream stream(payload);
+    quint8      type;
+    stream >> type;
+
+    switch (type)
+    {
+      case QVggRemoteProtocol::Load:
+      {
+        QByteArray filePath, designDocSchemaFilePath, layoutDocSchemaFilePath;
+        stream >> filePath >> designDocSchemaFilePath >> layoutDocSchemaFilePath;
+        load(filePath.toStdString(), designDocSchemaFilePath, layoutDocSchemaFilePath);
+        break;
+      }
+      case QVggRemoteProtocol::Resize:
+      {
+        int     width, height;
+        double  devicePixelRatio;
+        QString memoryKey;
+        quint32 generation;
+        stream >> width >> height >> devicePixelRatio >> memoryKey >> generation;
+        resize(QSize(width, height), devicePixelRatio, memoryKey, generation);
+        break;
+      }
+      case QVggRemoteProtocol::Input:
+      {
+        QByteArray bytes;
+        stream >> bytes;
+        if (bytes.size() != sizeof(UEvent))
+        {
+          break;
+        }
+        UEvent evt;
+        std::memcpy(&evt, bytes.constData(), sizeof(evt));
+        m_keyboardState.apply(evt);
+        QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+        m_container->onEvent(evt);
+        break;
+      }
+      case QVggRemoteProtocol::UpdateElements:
+      {
+        QList<QByteArray> ids, patches;
+        stream >> ids >> patches;
+        for (int i = 0; i < ids.size() && i < patches.size(); ++i)
+        {
+          m_container->sdk()->updateElement(ids[i].toStdString(), patches[i].toStdString());
+        }
+        break;
+      }
+      case QVggRemoteProtocol::GetElement:
+      {
+        quint32    request;
+        QByteArray id;
+        stream >> request >> id;
+        send(QVggRemoteProtocol::message(
+          QVggRemoteProtocol::Element,
+          request,
+          QByteArray::fromStdString(m_container->sdk()->getElement(id.toStdString()))));
+        break;
+      }
+      case QVggRemoteProtocol::ReleaseFrame:
+      {
+        quint32 generation;
+        int     buffer;
+        stream >> generation >> buffer;
+        if (generation == m_generation && buffer >= 0 && buffer < QVggRemoteProtocol::FRAME_BUFFERS)
+        {
+          m_busy[buffer] = false;
+        }
+        break;
+      }
+      case QVggRemoteProtocol::Ping:
+        send(QVggRemoteProtocol::message(QVggRemoteProtocol::Pong));
+        break;
+      default:
+        break;
+    }
+  }
+
+  void load(
+    const std::string& filePath,
+    const QByteArray&  designDocSchemaFilePath,
+    const QByteArray&  layoutDocSchemaFilePath)
+  {
+    QVggEnvironment::setUpFor(filePath);
+    const auto result = m_container->load(
+      filePath,
+      designDocSchemaFilePath.isEmpty() ? nullptr : designDocSchemaFilePath.constData(),
+      layoutDocSchemaFilePath.isEmpty() ? nullptr : layoutDocSchemaFilePath.constData());
+    m_needsFrame = true;
+    send(QVggRemoteProtocol::message(QVggRemoteProtocol::Loaded, result));
+  }
+
+  void resize(QSize size, double devicePixelRatio, const QString& memoryKey, quint32 generation)
+  {
+    m_memory.detach();
+    m_memory.setKey(memoryKey);
+    if (!m_memory.attach())
+    {
+      qWarning().noquote() << "VggRenderHost: cannot attach," << m_memory.errorString();
+      return;
+    }
+    m_generation = generation;
+    m_busy.fill(false);
+
+    // The container takes the bound framebuffer as its target when it is initialized or resized.
+    m_context.makeCurrent(&m_surface);
+    m_fbo = std::make_unique<QOpenGLFramebufferObject>(
+      (QSizeF(size) * devicePixelRatio).toSize(),
+      QOpenGLFramebufferObject::CombinedDepthStencil);
+    m_fbo->bind();
+    if (!m_initialized)
+    {
+      m_container->init(size.width(), size.height(), devicePixelRatio);
+      m_initialized = true;
+    }
+
+    UEvent evt;
+    evt.window.type = VGG_WINDOWEVENT;
+    evt.window.event = VGG_WINDOWEVENT_SIZE_CHANGED;
+    evt.window.data1 = size.width();
+    evt.window.data2 = size.height();
+    evt.window.drawableWidth = m_fbo->width();
+    evt.window.drawableHeight = m_fbo->height();
+    m_container->onEvent(evt);
+    m_fbo->release();
+    m_needsFrame = true;
+  }
+
+  void tick()
+  {
+    m_container->dispatch();
+    if ((m_container->needsPaint() || m_needsFrame) && m_fbo && m_memory.isAttached())
+    {
+      render();
+    }
+  }
+
+  // Renders into a buffer the application released, or waits for one.
+  void render()
+  {
+    int buffer = 0;
+    while (buffer < QVggRemoteProtocol::FRAME_BUFFERS && m_busy[buffer])
+    {
+      ++buffer;
+    }
+    if (buffer == QVggRemoteProtocol::FRAME_BUFFERS)
+    {
+      return;
+    }
+
+    m_context.makeCurrent(&m_surface);
+    m_fbo->bind();
+    m_container->paint(true);
+    const auto image = m_fbo->toImage(true);
+    m_fbo->release();
+
+    const auto bufferBytes = m_memory.size() / QVggRemoteProtocol::FRAME_BUFFERS;
+    if (image.sizeInBytes() > bufferBytes)
+    {
+      return;
+    }
+    std::memcpy(
+      static_cast<char*>(m_memory.data()) + buffer * bufferBytes,
+      image.constBits(),
+      image.sizeInBytes());
+
+    m_busy[buffer] = true;
+    m_needsFrame = false;
+    send(QVggRemoteProtocol::message(
+      QVggRemoteProtocol::Frame,
+      m_generation,
+      buffer,
+      image.width(),
+      image.height(),
+      static_cast<int>(image.bytesPerLine()),
+      static_cast<int>(image.format())));
+  }
+
+private:
+  QLocalSocket m_socket;
+  QByteArray   m_readBuffer;
+
+  QOffscreenSurface                         m_surface;
+  QOpenGLContext                            m_context;
+  std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+  std::unique_ptr<VGG::QtContainer>         m_container;
+  QVggKeyboardState                         m_keyboardState;
+  bool                                      m_initialized{ false };
+  bool                                      m_needsFrame{ false };
+  QTimer                                    m_ticker;
+
+  QSharedMemory                                       m_memory;
+  quint32                                             m_generation{ 0 };
+  std::array<bool, QVggRemoteProtocol::FRAME_BUFFERS> m_busy{};
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+
+  QGuiApplication app(argc, argv);
+  if (app.arguments().size() < 3)
+  {
+    qCritical("usage: VggRenderHost <server> <token>");
+    return 2;
+  }
+
+  QVggEventAdapter::setup();
+
+  RenderHost host;
+  if (!host.start(app.arguments().at(1), app.arguments().at(2).toLatin1()))
+  {
+    return 1;
+  }
+
+  const auto result = app.exec();
+  host.stop();
+  QVggEnvironment::tearDown();
+  return result;
+}
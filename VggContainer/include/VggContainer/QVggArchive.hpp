@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// Read-only view of a vgg document, either a .daruma (zip) archive or an unpacked directory.
+class QVggArchive
+{
+public:
+  explicit QVggArchive(const QString& filePath);
+
+  bool isValid() const;
+  bool isDirectory() const;
+
+  const QStringList& entries() const;
+  bool               contains(const QString& name) const;
+
+  bool hasScripts() const;
+
+  // Returns the entry content, or a null array if it is missing or cannot be decompressed.
+  QByteArray read(const QString& name) const;
+
+  // Writes every entry below directoryPath, keeping the archive layout.
+  bool extractTo(const QString& directoryPath) const;
+
+  // Changes whenever the entry content changes: the crc and size of zip entries, the modification
+  // time and size of files in a directory.
+  quint64 stamp(const QString& name) const;
+
+private:
+  bool readZipDirectory();
+  void readDirectory();
+
+private:
+  struct ZipEntry
+  {
+    quint32 localHeaderOffset{ 0 };
+    quint32 crc{ 0 };
+    quint32 compressedSize{ 0 };
+    quint32 size{ 0 };
+    quint16 method{ 0 };
+  };
+
+  QString                  m_filePath;
+  QStringList              m_entries;
+  QHash<QString, ZipEntry> m_zipEntries;
+  bool                     m_isDirectory;
+  bool                     m_isValid;
+};
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VGG/QtContainer.hpp"
+
+#include <QObject>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Containers created ahead of time, so new QVggOpenGLWidgets do not pay for the construction and
+// document loading when they are shown.
+//
+// Containers are created and loaded on the GUI thread, one per event loop iteration. Preparing a
+// pool does not block startup as a whole, but every creation or load blocks the event loop while
+// it runs. Must be used from the GUI thread.
+class QVggContainerPool : public QObject
+{
+  Q_OBJECT
+
+public:
+  static QVggContainerPool& instance();
+
+  // Keeps count empty containers ready, taken containers are replaced.
+  void prepare(int count);
+
+  // Loads filePath into count containers, validated against the given schemas. A widget loading
+  // filePath with the same schemas and without image downsampling adopts one of them.
+  void prepare(
+    const std::string& filePath,
+    int                count,
+    const char*        designDocSchemaFilePath = nullptr,
+    const char*        layoutDocSchemaFilePath = nullptr);
+
+  // Returns a ready container, or a new one if the pool is empty.
+  std::unique_ptr<VGG::QtContainer> take();
+
+  // Returns a container with filePath loaded with the same schemas, or nullptr if none is ready.
+  std::unique_ptr<VGG::QtContainer> take(
+    const std::string& filePath,
+    const char*        designDocSchemaFilePath = nullptr,
+    const char*        layoutDocSchemaFilePath = nullptr);
+
+  void clear();
+
+private:
+  // file path, design schema path, layout schema path
+  using TDocument = std::tuple<std::string, std::string, std::string>;
+
+  QVggContainerPool() = default;
+
+  static TDocument document(
+    const std::string& filePath,
+    const char*        designDocSchemaFilePath,
+    const char*        layoutDocSchemaFilePath);
+
+  void schedule();
+  void createNext();
+
+private:
+  std::vector<std::unique_ptr<VGG::QtContainer>>                       m_containers;
+  std::map<TDocument, std::vector<std::unique_ptr<VGG::QtContainer>>> m_loadedContainers;
+  std::map<TDocument, int>                                             m_pendingLoads;
+
+  int  m_targetCount{ 0 };
+  bool m_scheduled{ false };
+};
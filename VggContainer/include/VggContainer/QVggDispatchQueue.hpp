@@ -0,0 +1,99 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VggContainer/QVggEventQueue.hpp"
+
+#include "VGG/Event.hpp"
+
+#include <QMetaType>
+#include <QObject>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Readable from QML as the value of QVggQuickItem::dispatchStats().
+struct QVggDispatchStats
+{
+  Q_GADGET
+  Q_PROPERTY(qint64 inputQueueDepth MEMBER inputQueueDepth)
+  Q_PROPERTY(qint64 eventQueueDepth MEMBER eventQueueDepth)
+  Q_PROPERTY(qint64 overflowedEvents MEMBER overflowedEvents)
+  Q_PROPERTY(qint64 dispatches MEMBER dispatches)
+  Q_PROPERTY(qint64 overruns MEMBER overruns)
+  Q_PROPERTY(double lastDispatchMs MEMBER lastDispatchMs)
+  Q_PROPERTY(double maxDispatchMs MEMBER maxDispatchMs)
+
+public:
+  qint64 inputQueueDepth{ 0 };
+  qint64 eventQueueDepth{ 0 };
+  qint64 overflowedEvents{ 0 }; // events beyond the capacity of the event queue
+  qint64 dispatches{ 0 };
+  qint64 overruns{ 0 }; // ticks that took longer than the budget
+  double lastDispatchMs{ 0 };
+  double maxDispatchMs{ 0 };
+};
+Q_DECLARE_METATYPE(QVggDispatchStats)
+
+// Input waiting for the container and the per tick budget for handling it.
+//
+// With a budget, a tick applies queued input until the budget is used and leaves the rest for the
+// next tick, event delivery works the same. Input arriving while nothing is queued can be applied
+// right away. The runtime's own dispatch() cannot be interrupted, ticks where it alone exceeds the
+// budget are counted as overruns.
+class QVggDispatchQueue
+{
+public:
+  // In milliseconds, 0 for no budget.
+  void   setBudget(double budgetMs);
+  double budget() const;
+
+  // Ignores the budget while set, e.g. when a virtual clock drives the ticks, so every tick
+  // applies all queued input no matter how long it takes.
+  void setBudgetSuspended(bool suspended);
+
+  // Thread safe.
+  void post(const UEvent& evt);
+  bool isEmpty() const;
+
+  // Applies all queued input with onEvent, ignoring the budget, e.g. before input is applied
+  // directly again after the budget changed. Call under the container lock.
+  void drain(const std::function<void(UEvent& evt)>& onEvent);
+
+  // Applies queued input with onEvent, then calls dispatch once. Call under the container lock.
+  void run(const std::function<void(UEvent& evt)>& onEvent, const std::function<void()>& dispatch);
+
+  // Hands queued events to handle until the budget is used, returns false if events are left.
+  bool deliver(
+    QVggEventQueue&                                          events,
+    const std::function<void(QVggEventQueue::Event& event)>& handle);
+
+  QVggDispatchStats stats(const QVggEventQueue& events) const;
+
+private:
+  std::int64_t effectiveBudgetNs() const;
+
+private:
+  std::atomic<std::int64_t> m_budgetNs{ 0 };
+  std::atomic_bool          m_budgetSuspended{ false };
+
+  mutable std::mutex m_lock;
+  std::deque<UEvent> m_input;
+  QVggDispatchStats  m_stats;
+};
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Runs the dispatch of a container on its own thread, so slow script handlers do not block the
+// GUI thread. The task runs once per interval, or earlier after wake(), e.g. when input arrives.
+// The task must take the container lock itself. The thread stops when the dispatcher is destroyed.
+class QVggDispatcher
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit QVggDispatcher(
+    Task                      task,
+    std::chrono::milliseconds interval = std::chrono::milliseconds(16));
+  ~QVggDispatcher();
+
+  QVggDispatcher(const QVggDispatcher&) = delete;
+  QVggDispatcher& operator=(const QVggDispatcher&) = delete;
+
+  void wake();
+
+private:
+  void run();
+
+private:
+  Task                      m_task;
+  std::chrono::milliseconds m_interval;
+
+  std::mutex              m_lock;
+  std::condition_variable m_wakeUp;
+  bool                    m_woken{ false };
+  bool                    m_stopped{ false };
+
+  std::thread m_thread;
+};
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VGG/ISdk.hpp"
+
+#include <QJsonObject>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Element access to the document of a container, used by QVggElement. Calls are made on the
+// thread that owns the container and under its lock. The invoker and forwarder run without the
+// lock of this class, so they may take the container lock in any order.
+class QVggDocumentAccess
+{
+public:
+  // Runs the function with the sdk of the container, does nothing if there is no container.
+  using Invoker = std::function<void(const std::function<void(VGG::ISdk& sdk)>& function)>;
+
+  // Element access through the owner of the container, e.g. one without an sdk in this process
+  // (see QVggRemoteContainer) or one applying updates on its dispatch thread.
+  struct Forwarder
+  {
+    using Updates = std::vector<std::pair<std::string, std::string>>; // id, patch
+
+    std::function<std::string(const std::string& id)> getElement;
+    // Updates of a batch are forwarded together.
+    std::function<void(const Updates& updates)> updateElements;
+  };
+
+  explicit QVggDocumentAccess(Invoker invoker);
+  explicit QVggDocumentAccess(Forwarder forwarder);
+
+  // Called by the container when it is destroyed, waits for calls in flight, later calls do
+  // nothing.
+  void detach();
+
+  // Returns an empty string if the element does not exist.
+  std::string getElement(const std::string& id);
+  // Return the revision of the element after the update.
+  std::uint64_t updateElement(const std::string& id, const std::string& patch);
+  std::uint64_t updateElement(const std::string& id, const QJsonObject& patch);
+
+  // Raised for an element by every update made through this access, and for all elements by
+  // resetBatch(). Changes made by scripts of the document do not raise it.
+  std::uint64_t revision(const std::string& id);
+
+  // Updates made between beginBatch() and the matching commitBatch() are held back, patches of the
+  // same element are merged, and all of them are applied at once under the container lock. Batches
+  // nest, the outermost commit applies. Use QVggTransaction instead of calling these directly.
+  void beginBatch();
+  void commitBatch();
+  // Drops held back updates and closes open batches, e.g. one left open by beginUpdate() without
+  // endUpdate(), and raises the revision of every element. Called when a document is loaded.
+  void resetBatch();
+
+  void invoke(const std::function<void(VGG::ISdk& sdk)>& function);
+
+private:
+  // Called without m_lock held.
+  void apply(const Forwarder::Updates& updates);
+
+  // Copies the invoker and forwarder for a call made without m_lock. Returns false after detach(),
+  // otherwise endCall() must follow.
+  bool beginCall(Invoker& invoker, Forwarder& forwarder);
+  void endCall();
+
+  // Called with m_lock held.
+  std::uint64_t raiseRevision(const std::string& id);
+
+private:
+  std::mutex              m_lock;
+  Invoker                 m_invoker;
+  Forwarder               m_forwarder;
+  int                     m_calls{ 0 };
+  std::condition_variable m_callsEnded;
+
+  int                                              m_batchDepth{ 0 };
+  std::vector<std::pair<std::string, QJsonObject>> m_pending;
+  std::unordered_map<std::string, std::size_t>     m_pendingIndex;
+
+  std::uint64_t                                  m_revision{ 0 };
+  std::uint64_t                                  m_loadRevision{ 0 };
+  std::unordered_map<std::string, std::uint64_t> m_revisions;
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Watches a loaded document and reports what changed when it is saved again.
+//
+// Changes to element properties are reported as one JSON merge patch per element, to be applied
+// with updateElement() so the container keeps its state. Added, removed or moved elements are
+// reported as patches replacing the childObjects of their parents, the way QVggModelBinding
+// repeats rows. Patches come in document order, parents first. Any other change, such as frames,
+// scripts or resources, requires a reload.
+class QVggDocumentWatcher
+{
+public:
+  struct Change
+  {
+    bool                                             needsReload{ false };
+    std::vector<std::pair<std::string, std::string>> elementPatches; // id, merge patch
+  };
+  using ChangeHandler = std::function<void(const Change& change)>;
+
+  explicit QVggDocumentWatcher(ChangeHandler handler);
+
+  void watch(const QString& filePath);
+  void stop();
+
+  const QString& filePath() const;
+
+private:
+  void onFileChanged();
+  void readDocument(QJsonObject& design, QHash<QString, quint64>& stamps) const;
+
+private:
+  ChangeHandler           m_handler;
+  QFileSystemWatcher      m_watcher;
+  QTimer                  m_debounce;
+  QString                 m_filePath;
+  QJsonObject             m_design;
+  QHash<QString, quint64> m_stamps; // other entries of the archive
+};
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VggContainer/QVggDocumentAccess.hpp"
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Handle to a document element, resolved once from its id and reused for every access.
+//
+// Properties are addressed with JSON pointers such as "/style/fills/0/color/alpha". The element is
+// read once and cached, setters update the cache and send the runtime a patch holding only the
+// changed property instead of the whole element. The runtime replaces arrays whole, so a change
+// inside an array sends the cached array. The element is read again first only when it was updated
+// through another handle or a document was loaded since it was cached, see
+// QVggDocumentAccess::revision(). Call refresh() after the element was changed by a script of the
+// document, which the cache cannot notice. Copies share the cache.
+class QVggElement
+{
+public:
+  QVggElement() = default;
+  QVggElement(std::shared_ptr<QVggDocumentAccess> access, std::string id);
+
+  bool               isValid() const;
+  const std::string& id() const;
+
+  QJsonValue value(const QString& path) const;
+  double     toDouble(const QString& path, double defaultValue = 0) const;
+  QString    toString(const QString& path, const QString& defaultValue = {}) const;
+  bool       toBool(const QString& path, bool defaultValue = false) const;
+
+  // An object value is sent as its difference to the cached one. Null removes the member, inside an
+  // object value it fails.
+  bool setValue(const QString& path, const QJsonValue& value);
+
+  // Applies a JSON merge patch (RFC 7386), null removes a member and arrays are replaced whole.
+  bool applyPatch(const QJsonObject& mergePatch);
+  // Same as applyPatch() with the patch encoded as a CBOR map, which skips formatting and
+  // parsing JSON text. With nlohmann::json, encode it with nlohmann::json::to_cbor().
+  bool applyCborPatch(const QByteArray& mergePatch);
+  // Applies a JSON Patch (RFC 6902) with all of its operations, or none if one of them fails.
+  bool applyJsonPatch(const QJsonArray& operations);
+
+  QByteArray  toCbor() const;
+  QJsonObject toJson() const;
+  void        refresh();
+
+  // Splits a JSON pointer into unescaped reference tokens, returns false if it is malformed.
+  static bool parsePath(const QString& path, QStringList& tokens);
+  // Builds an RFC 7386 merge patch from "from" to "to", removed members are sent as null. Returns
+  // false if a member became null, which a merge patch cannot express.
+  static bool makeMergePatch(const QJsonObject& from, const QJsonObject& to, QJsonObject& patch);
+
+private:
+  struct Data
+  {
+    std::shared_ptr<QVggDocumentAccess> access;
+    std::string                         id;
+    QJsonObject                         element;
+    bool                                loaded{ false };
+    std::uint64_t                       revision{ 0 };
+  };
+
+  const QJsonObject& element() const;
+  // Whether the cache holds every update made through the access since it was read.
+  bool isCurrent() const;
+
+  std::shared_ptr<Data> m_data;
+};
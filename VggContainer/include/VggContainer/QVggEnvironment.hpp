@@ -0,0 +1,42 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+// Starts the vgg runtime environment (and its JavaScript engine) on demand, so processes that only
+// show script-free documents never boot it.
+class QVggEnvironment
+{
+public:
+  // Starts the environment now. Safe to call more than once and from any thread.
+  static void setUp();
+
+  // Starts the environment only if the document at filePath contains scripts.
+  static void setUpFor(const std::string& filePath);
+
+  // Tears the environment down if it was started.
+  static void tearDown();
+
+  // Renders with the CPU rasterizer of Mesa (llvmpipe) on hosts without a GPU, binning each frame
+  // into tiles rasterized on threads threads, all cores when 0. Variables set by the user are
+  // kept. Must be called before the application is created.
+  static void setUpSoftwareRendering(int threads = 0);
+
+  static bool isSetUp();
+  static bool hasScripts(const std::string& filePath);
+};
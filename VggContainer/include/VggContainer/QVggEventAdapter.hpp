@@ -21,6 +21,43 @@
 
 #include <QKeyEvent>
 
+#include <array>
+#include <cstdint>
+
+// Pressed keys and modifiers of one container. The runtime reads them through the registered
+// QVggEventAdapter while a Scope of the state is alive on the calling thread.
+class QVggKeyboardState {
+public:
+  class Scope {
+  public:
+    explicit Scope(QVggKeyboardState &state);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    QVggKeyboardState *m_previous;
+  };
+
+  // Records key events, call it right before the container handles the event.
+  void apply(const UEvent &event);
+
+  // The state of the innermost scope on this thread, or nullptr.
+  static QVggKeyboardState *current();
+
+  // Whether the last applied event was a key event, only then modState() is current.
+  bool isKeyEvent() const;
+  EVGGKeymod modState() const;
+  uint8_t *keys();
+
+private:
+  std::array<uint8_t, VGG_NUM_SCANCODES> m_keys{};
+  EVGGKeymod m_modState{VGG_KMOD_NONE};
+  bool m_keyEvent{false};
+};
+
+// Translates Qt key events for the runtime, shared by the widget and the quick containers.
 class QVggEventAdapter : public EventAPI {
 public:
   static void setup();
@@ -33,5 +70,5 @@ public:
 
 private:
   static EVGGKeymod toVggModState(Qt::KeyboardModifiers keyboardModifiers);
-  static EVGGKeyCode toVggKeyCode(int key);
+  static EVGGScancode toVggScancode(int key, Qt::KeyboardModifiers keyboardModifiers);
 };
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Lock-free queue of document events, so events raised under the container lock can be handled
+// later without it. Any thread may push or pop. Events never get lost: when the ring is full, they
+// go to a locked overflow list, and so do later ones until the list is drained, keeping the order.
+class QVggEventQueue
+{
+public:
+  struct Event
+  {
+    std::string type;
+    std::string targetId;
+    std::string targetPath;
+  };
+
+  // The capacity is rounded up to a power of two.
+  explicit QVggEventQueue(std::size_t capacity = 1024);
+
+  void push(Event&& event);
+  bool pop(Event& event);
+
+  // Approximate while other threads push or pop.
+  std::size_t size() const;
+  // Events that went to the overflow list, a capacity too small for the load when it grows.
+  std::size_t overflowed() const;
+
+private:
+  bool pushCell(Event& event);
+  bool popCell(Event& event);
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    Event                    event;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  std::size_t             m_mask;
+
+  alignas(64) std::atomic<std::size_t> m_pushPosition{ 0 };
+  alignas(64) std::atomic<std::size_t> m_popPosition{ 0 };
+
+  std::mutex               m_overflowLock;
+  std::deque<Event>        m_overflow;
+  std::atomic<std::size_t> m_overflowSize{ 0 };
+  std::atomic<std::size_t> m_overflowed{ 0 };
+};
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Event of a document element, valid during the handler call only.
+struct QVggEvent
+{
+  const std::string& type;
+  const std::string& targetId;
+  const std::string& targetPath;
+};
+
+// Routes document events to handlers subscribed by event type and target, so only matching
+// events reach application code. Routing does not allocate.
+//
+// A target is an element id or path, e.g. "#counterButton". A trailing '*' matches any id or path
+// with that prefix, an empty target matches every element. An empty type matches every type.
+class QVggEventRouter
+{
+public:
+  using Handler = std::function<void(const QVggEvent& event)>;
+
+  int  subscribe(const std::string& type, const std::string& target, Handler handler);
+  void unsubscribe(int subscription);
+  bool isEmpty() const;
+
+  // Returns whether a handler was called.
+  bool route(const std::string& type, const std::string& targetId, const std::string& targetPath);
+
+private:
+  struct Subscription
+  {
+    int         id;
+    std::string target;
+    Handler     handler;
+
+    bool matches(std::string_view targetId, std::string_view targetPath) const;
+  };
+
+  struct Table
+  {
+    std::unordered_map<std::string, std::vector<Subscription>> byType;
+    std::vector<Subscription>                                  anyType;
+  };
+
+  // Replaced on change, so handlers may subscribe or unsubscribe while being routed to.
+  std::shared_ptr<const Table> table() const;
+
+  mutable std::mutex           m_lock;
+  std::shared_ptr<const Table> m_table{ std::make_shared<Table>() };
+  int                          m_nextId{ 1 };
+};
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QSize>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QOpenGLContext;
+
+// A rendered frame as 8-bit RGBA rows, top row first.
+struct QVggFrame
+{
+  const std::uint8_t* data;
+  int                 width;
+  int                 height;
+  int                 stride;
+  double              timestampMs;
+  std::uint64_t       index;
+};
+
+// Streams the frames a container renders to a sink, e.g. a pipe to a video encoder.
+//
+// capture() starts an asynchronous read of the render target into a ring of pixel buffer
+// objects, frames are mapped a few captures later, when the GPU is done with them, and copied to
+// a bounded ring of CPU buffers that a writer thread hands to the sink. When the sink falls
+// behind, capture() blocks, or drops the frame with Backpressure::Drop, so memory use stays fixed.
+// Without pixel buffer objects (OpenGL below 3.0, OpenGL ES below 3.0) frames are read
+// synchronously.
+class QVggFrameExporter
+{
+public:
+  // Returns false to stop the export.
+  using Sink = std::function<bool(const QVggFrame& frame)>;
+
+  enum class Backpressure
+  {
+    Block,
+    Drop
+  };
+
+  explicit QVggFrameExporter(
+    Sink         sink,
+    int          ringSize = 3,
+    Backpressure backpressure = Backpressure::Block);
+  ~QVggFrameExporter();
+
+  QVggFrameExporter(const QVggFrameExporter&) = delete;
+  QVggFrameExporter& operator=(const QVggFrameExporter&) = delete;
+
+  // Writes the rows of each frame to the file descriptor, preceded by the timestamp in
+  // microseconds as a little-endian int64 when timestamps is set. The descriptor stays open.
+  static Sink fileDescriptorSink(int fd, bool timestamps = false);
+
+  // Called on the render thread with the context current and the frame rendered into fbo. Rows
+  // of GL framebuffers start at the bottom, pass bottomUp false for targets whose first row is
+  // the top of the frame, like the FBO of the quick container.
+  void capture(
+    QOpenGLContext* context,
+    unsigned        fbo,
+    const QSize&    size,
+    double          timestampMs,
+    bool            bottomUp = true);
+  // Milliseconds since the exporter was created, for containers without a virtual clock.
+  double elapsed() const;
+
+  // Hands the frames in flight to the sink and frees the GL resources, called on the render
+  // thread with the context current. The exporter can be used again afterwards.
+  void finish(QOpenGLContext* context);
+
+  bool          isStopped() const;
+  std::uint64_t dropped() const;
+
+private:
+  struct Buffer
+  {
+    std::vector<std::uint8_t> pixels;
+    QVggFrame                 frame;
+  };
+
+  struct PendingRead
+  {
+    unsigned      pbo{ 0 };
+    void*         fence{ nullptr };
+    QSize         size;
+    double        timestampMs{ 0 };
+    std::uint64_t index{ 0 };
+    bool          bottomUp{ true };
+    bool          inFlight{ false };
+  };
+
+  void    readSynchronously(
+    QOpenGLContext* context,
+    unsigned        fbo,
+    const QSize&    size,
+    double          timestampMs,
+    bool            bottomUp);
+  void    collect(QOpenGLContext* context, PendingRead& read);
+  Buffer* acquireBuffer();
+  void    queueBuffer(Buffer* buffer);
+  void    write();
+
+private:
+  Sink          m_sink;
+  Backpressure  m_backpressure;
+  QElapsedTimer m_clock;
+  std::uint64_t m_nextIndex{ 0 };
+
+  // Render thread only.
+  std::vector<PendingRead> m_reads;
+  std::size_t              m_nextRead{ 0 };
+
+  mutable std::mutex      m_lock;
+  std::condition_variable m_changed;
+  std::vector<Buffer>     m_buffers;
+  std::vector<Buffer*>    m_free;
+  std::deque<Buffer*>     m_queued;
+  bool                    m_writing{ false };
+  bool                    m_stopped{ false };
+  bool                    m_quit{ false };
+  std::uint64_t           m_dropped{ 0 };
+
+  std::thread m_writer;
+};
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+
+#include <string>
+
+// Prepares a document for loading with its raster images decoded no larger than they are displayed.
+//
+// The display size of every image is taken from the design document (element bounds scaled by the
+// element transforms), images larger than that size times the device pixel ratio and zoom headroom
+// are decoded at the reduced size in parallel and the document is unpacked into a cache directory.
+// Images drawn at their own size, e.g. by tiled fills, are kept. Prepared documents are reused
+// until the source document changes, the least recently used ones are removed beyond the limit.
+class QVggImageDownsampler
+{
+public:
+  struct Options
+  {
+    double  devicePixelRatio{ 1.0 };
+    double  zoomHeadroom{ 2.0 };                // zoom level up to which images stay sharp
+    QString cacheDirectory;                     // defaults to <cache location>/vgg/images
+    qint64  cacheLimit{ 1024LL * 1024 * 1024 }; // bytes of prepared documents kept
+  };
+
+  // Returns the path to load, which is filePath itself when there is nothing to downsample.
+  static std::string prepare(const std::string& filePath, const Options& options);
+};
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+// Timings of the last load() of a container up to its first frame, in milliseconds.
+//
+// Archive reading, JSON parsing, schema validation, layout and resource decoding happen inside the
+// runtime load and are reported together as loadMs.
+struct QVggLoadTimings
+{
+  // process wide, the same for every container
+  double environmentSetUpMs{ 0 };  // JavaScript environment start, 0 while it is not started
+  double eventAdapterSetUpMs{ 0 }; // QVggEventAdapter::setup
+
+  double containerCreateMs{ 0 }; // container construction
+  double initMs{ 0 };            // container init, creates the GPU backend
+  double scriptCheckMs{ 0 };     // script lookup and environment start, see QVggEnvironment
+  double imagePrepareMs{ 0 };    // image downsampling, see QVggImageDownsampler
+  double schemaCheckMs{ 0 };     // document hash and validation cache lookup
+  double loadMs{ 0 };            // runtime load, includes schema validation when validated is true
+  double firstPaintMs{ 0 };      // the first paint after the load
+  double loadToFirstFrameMs{ 0 };
+  double processStartToFirstFrameMs{ 0 };
+
+  qint64 peakMemoryBytes{ 0 }; // peak resident memory of the process at the first frame
+
+  bool validated{ false }; // false when the document was validated before with the same schemas
+  bool preloaded{ false }; // the document was loaded ahead of time by QVggContainerPool
+  bool complete{ false };  // the first frame after the load was painted
+
+  // Single line for the logs, also written to the "vgg.load" logging category at info level.
+  QString toString() const;
+
+  // Fills the process wide fields and the first frame fields, and logs the record.
+  void finish(double firstPaintMs, double loadToFirstFrameMs);
+
+  static void   recordEnvironmentSetUp(double ms);
+  static void   recordEventAdapterSetUp(double ms);
+  static double processUptimeMs();
+  static qint64 processPeakMemoryBytes();
+};
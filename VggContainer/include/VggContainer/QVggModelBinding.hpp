@@ -0,0 +1,142 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VggContainer/QVggDocumentAccess.hpp"
+#include "VggContainer/QVggElement.hpp"
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+
+// Keeps document elements in sync with a Qt model and with QObject properties.
+//
+// A role binding maps a model role to an element property, the element id contains %1 for the
+// row, e.g. bindRole(StateRole, "#state%1", "/content") updates "#state0", "#state1", ... Changes
+// are collected and applied once per event loop iteration in one transaction, only cells whose
+// value differs from the element are sent.
+//
+// With a row template, the child named templateName of the container element is repeated once per
+// model row, clones and their descendants get the row appended to their names and are offset by
+// rowOffset per row. The clones are added by replacing the childObjects of the container, in the
+// same transaction as the cells. Inserted, removed or moved rows update the cells from the first
+// affected row on. Must be used from the GUI thread.
+class QVggModelBinding : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(QAbstractItemModel* model READ model WRITE setModel NOTIFY modelChanged)
+
+public:
+  QVggModelBinding(std::shared_ptr<QVggDocumentAccess> access, QObject* parent = nullptr);
+
+  QAbstractItemModel* model() const;
+  void                setModel(QAbstractItemModel* model);
+
+  Q_INVOKABLE void bindRole(
+    int            role,
+    const QString& elementId,
+    const QString& path,
+    int            column = 0);
+  Q_INVOKABLE void bindRole(
+    const QString& roleName,
+    const QString& elementId,
+    const QString& path,
+    int            column = 0);
+  Q_INVOKABLE void setRowTemplate(
+    const QString& containerId,
+    const QString& templateName,
+    const QPointF& rowOffset);
+
+  // The property must have a notify signal.
+  Q_INVOKABLE bool bindProperty(
+    QObject*       object,
+    const QString& property,
+    const QString& elementId,
+    const QString& path);
+
+  Q_INVOKABLE void clear();
+
+  // Reads the elements again and applies every binding, call it after the document is reloaded.
+  Q_INVOKABLE void refresh();
+
+  // Applies pending changes now instead of on the next event loop iteration.
+  Q_INVOKABLE void flush();
+
+signals:
+  void modelChanged();
+
+private slots:
+  void onPropertyChanged();
+
+private:
+  struct RoleBinding
+  {
+    int     role;
+    QString roleName;
+    int     column;
+    QString elementId;
+    QString path;
+  };
+
+  struct PropertyBinding
+  {
+    QPointer<QObject> object;
+    int               propertyIndex;
+    QString           elementId;
+    QString           path;
+  };
+
+  void         connectModel();
+  void         resolveRoles();
+  void         markCells(
+    const QModelIndex&  topLeft,
+    const QModelIndex&  bottomRight,
+    const QVector<int>& roles);
+  void         markRows(int first);
+  void         markAll();
+  void         schedule();
+  void         updateRowTemplate();
+  QVggElement& element(const QString& id);
+
+private:
+  std::shared_ptr<QVggDocumentAccess> m_access;
+  QPointer<QAbstractItemModel>        m_model;
+  QVector<QMetaObject::Connection>    m_modelConnections;
+
+  QVector<RoleBinding>     m_roleBindings;
+  QVector<PropertyBinding> m_propertyBindings;
+
+  QString     m_containerId;
+  QString     m_templateName;
+  QPointF     m_rowOffset;
+  QJsonArray  m_children; // of the container before the template was repeated
+  int         m_templateIndex{ -1 };
+
+  QHash<QString, QVggElement> m_elements;
+  QSet<QPair<int, int>>       m_dirtyCells; // row, index into m_roleBindings
+  QSet<int>                   m_dirtyProperties;
+  int                         m_dirtyFromRow{ -1 }; // rows from here on moved
+  int                         m_rowCount{ 0 };      // when last flushed
+  bool                        m_dirtyAll{ false };
+  bool                        m_scheduled{ false };
+};
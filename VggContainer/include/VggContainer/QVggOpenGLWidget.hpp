@@ -18,7 +18,17 @@
 
 #include <QOpenGLWidget>
 
+#include <future>
+
 #include "VGG/ISdk.hpp"
+#include "VggContainer/QVggDispatchQueue.hpp"
+#include "VggContainer/QVggElement.hpp"
+#include "VggContainer/QVggEventRouter.hpp"
+#include "VggContainer/QVggFrameExporter.hpp"
+#include "VggContainer/QVggImageDownsampler.hpp"
+#include "VggContainer/QVggLoadTimings.hpp"
+#include "VggContainer/QVggModelBinding.hpp"
+#include "VggContainer/QVggTransaction.hpp"
 
 class QVggOpenGLWidgetImpl;
 class QVggOpenGLWidget : public QOpenGLWidget {
@@ -29,6 +39,7 @@ public:
   using EventListener =
       std::function<void(std::shared_ptr<VGG::ISdk> vggSdk, std::string type,
                          std::string targetId, std::string targetPath)>;
+  using EventHandler = QVggEventRouter::Handler;
 
 public:
   QVggOpenGLWidget(QWidget *parent = nullptr);
@@ -37,13 +48,80 @@ public:
   bool load(const std::string &filePath,
             const char *designDocSchemaFilePath = nullptr,
             const char *layoutDocSchemaFilePath = nullptr);
+  // Receives every event, prefer subscribe() to receive only the events of interest.
   void setEventListener(EventListener listener);
 
+  // Calls the handler for events of the type, e.g. "mouseup", whose target id or path matches the
+  // target, e.g. "#counterButton" or "#counterButton*". Empty type or target match anything.
+  // Returns the subscription for unsubscribe().
+  int  subscribe(const std::string &type, const std::string &target,
+                 EventHandler handler);
+  void unsubscribe(int subscription);
+
+  // Handle to the element with the given id, e.g. "#counterButton". Keep it to access the
+  // element repeatedly, call QVggElement::refresh() after the document is reloaded.
+  QVggElement element(const std::string &id);
+
+  // Element updates made while the returned transaction is alive are applied together.
+  QVggTransaction transaction();
+
+  // Binds models and object properties to elements of the document, owned by the widget.
+  QVggModelBinding *modelBinding();
+
+  // Timings of the last load() up to its first frame, complete once that frame is painted.
+  // Enable the "vgg.load" logging category at info level to log them.
+  QVggLoadTimings loadTimings() const;
+
+  // Decode images no larger than displayed in documents loaded afterwards. Disabled by default.
+  void setImageDownsamplingEnabled(bool enabled, double zoomHeadroom = 2.0);
+
+  // Applies changes of the loaded file while it is edited. Changed elements are updated in place,
+  // keeping the view and runtime state, other changes reload the document.
+  void setWatchEnabled(bool enabled);
+
+  // Runs scripts and event dispatch on their own thread instead of the GUI thread, which then
+  // only forwards input, so slow scripts do not freeze the UI. Events are still handled on the
+  // GUI thread. Disabled by default.
+  void setDispatchThreadEnabled(bool enabled);
+
+  // Limits the time a dispatch tick spends on queued input, and on event handlers with the
+  // dispatch thread, the rest waits for the next tick. Input arriving while nothing is queued is
+  // applied right away. In milliseconds, 0 (the default) for no limit.
+  void                          setDispatchBudget(double budgetMs);
+  Q_INVOKABLE QVggDispatchStats dispatchStats() const;
+
+  // Stops the 16 ms animator, the application then drives the ticks with advance(), which runs the
+  // dispatch ticks of the interval back to back and schedules a paint, e.g. before
+  // grabFramebuffer(). Input is applied at the next tick. Animations and timers of the runtime keep
+  // its wall clock. The dispatch thread and the dispatch budget are not used meanwhile. Disabled by
+  // default.
+  void setVirtualClockEnabled(bool enabled);
+  void advance(double ms);
+
+  // Streams every painted frame to the exporter, timestamped by the virtual clock when enabled.
+  // Virtual timestamps match the content only for changes made by dispatch ticks, e.g. scripts
+  // reacting to input. Animations of the runtime follow its wall clock regardless, record them
+  // without the virtual clock, so frames are timestamped by the exporter's clock.
+  // Frames in flight are flushed when the exporter is replaced, nullptr stops the export.
+  void setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter);
+
+  // Copies rect, in widget coordinates and empty for the whole widget, from the latest frame,
+  // scaled by scale, e.g. 0.25 for a thumbnail. The image is read from the framebuffer on the
+  // next event loop iteration without painting again, or after the first paint. The future is
+  // then fulfilled and snapshotReady() emitted.
+  std::future<QImage> snapshot(const QRect &rect = QRect(), double scale = 1.0);
+
+signals:
+  void snapshotReady(QImage image);
+
 protected:
   virtual void initializeGL() override;
   virtual void resizeGL(int w, int h) override;
   virtual void paintGL() override;
 
+  // Touch points and native pinch/rotate gestures are batched and sent once per frame.
+  bool event(QEvent *event) override;
+
   void mousePressEvent(QMouseEvent *event) override;
   void mouseReleaseEvent(QMouseEvent *event) override;
   void mouseMoveEvent(QMouseEvent *event) override;
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QWidget>
+
+#include "VGG/ISdk.hpp"
+#include "VggContainer/QVggElement.hpp"
+#include "VggContainer/QVggEventRouter.hpp"
+#include "VggContainer/QVggLoadTimings.hpp"
+#include "VggContainer/QVggTransaction.hpp"
+
+// Shows a document without an OpenGL window, for hosts where QOpenGLWidget is not available,
+// e.g. remote desktops and virtual displays without GLX. Frames are rendered into an offscreen
+// surface, read back and presented with QPainter. Combined with
+// QVggEnvironment::setUpSoftwareRendering() it runs on the CPU only.
+//
+// Reading the frames back costs a copy per frame, prefer QVggOpenGLWidget where OpenGL windows
+// are available. Scripts and event dispatch run on the GUI thread.
+class QVggRasterWidgetImpl;
+class QVggRasterWidget : public QWidget {
+  Q_OBJECT
+  QVggRasterWidgetImpl *m_impl;
+
+public:
+  using EventListener =
+      std::function<void(std::shared_ptr<VGG::ISdk> vggSdk, std::string type,
+                         std::string targetId, std::string targetPath)>;
+  using EventHandler = QVggEventRouter::Handler;
+
+public:
+  QVggRasterWidget(QWidget *parent = nullptr);
+  ~QVggRasterWidget();
+
+  bool load(const std::string &filePath,
+            const char *designDocSchemaFilePath = nullptr,
+            const char *layoutDocSchemaFilePath = nullptr);
+  // Receives every event, prefer subscribe() to receive only the events of interest.
+  void setEventListener(EventListener listener);
+
+  // Same as QVggOpenGLWidget::subscribe().
+  int  subscribe(const std::string &type, const std::string &target,
+                 EventHandler handler);
+  void unsubscribe(int subscription);
+
+  QVggElement     element(const std::string &id);
+  QVggTransaction transaction();
+
+  // Timings of the last load() up to its first frame, complete once that frame is painted.
+  QVggLoadTimings loadTimings() const;
+
+  // The latest frame, in device pixels.
+  QImage frame() const;
+
+  // Keeps rendered frames as tiles of the canvas, up to memoryCapBytes. While the document is
+  // panned with a touchpad, frames are then composed from cached tiles where they cover the view,
+  // without rendering, and rendered once panning stops. Rendered frames are compared with the
+  // cached tiles, which are dropped when the content changed or moved differently than expected.
+  // Tiles are only composed after a rendered frame confirmed the expected pan. Zooming drops them
+  // as well. Disabled by default.
+  void setTiledRenderingEnabled(bool enabled, qint64 memoryCapBytes = 256 << 20);
+
+  // Hosts the document in a VggRenderHost process, see QVggRemoteContainer, so a crash or a
+  // runaway script of the document does not take down the application. load() then returns
+  // whether the host started, listeners receive a null sdk, and load timings and tiled rendering
+  // are not available. Call it before load(), elements taken before keep the previous container.
+  // Disabled by default.
+  void setOutOfProcessEnabled(bool enabled);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
+
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+
+  void keyPressEvent(QKeyEvent *event) override;
+  void keyReleaseEvent(QKeyEvent *event) override;
+};
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VGG/Event.hpp"
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QLocalServer>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class QLocalSocket;
+class QSharedMemory;
+
+// A container hosted by a VggRenderHost process, so a runtime crash or a runaway script of the
+// document does not take down the application. Input and element access go over a local socket,
+// frames come back through shared memory and are presented without copying them.
+//
+// The host is restarted and the document loaded again when it crashes or stops answering, the
+// last frame stays meanwhile. Must be used from the GUI thread.
+class QVggRemoteContainer : public QObject
+{
+  Q_OBJECT
+
+public:
+  using EventListener =
+    std::function<void(std::string type, std::string targetId, std::string targetPath)>;
+
+  explicit QVggRemoteContainer(QObject* parent = nullptr);
+  ~QVggRemoteContainer() override;
+
+  // The VggRenderHost executable, next to the application by default.
+  static void    setHostProgram(const QString& path);
+  static QString hostProgram();
+
+  // Starts the host if needed and queues the load. Returns false if the host cannot be started.
+  bool load(
+    const std::string& filePath,
+    const char*        designDocSchemaFilePath = nullptr,
+    const char*        layoutDocSchemaFilePath = nullptr);
+  void resize(QSize size, double devicePixelRatio);
+  void sendEvent(const UEvent& evt);
+
+  // Called on the GUI thread for every event of the document.
+  void setEventListener(EventListener listener);
+
+  // Waits up to a second for the host. Returns the last answer for the element, or an empty
+  // string, right away while the host does not answer pings. Events arriving meanwhile are
+  // delivered afterwards.
+  std::string getElement(const std::string& id);
+  // Applied together, before the next frame of the host.
+  void updateElements(const std::vector<std::pair<std::string, std::string>>& updates);
+
+  // The latest frame, in device pixels. It refers to the shared memory and is overwritten by the
+  // host after the next frameReady(), copy it to keep it.
+  QImage frame() const;
+
+signals:
+  void frameReady();
+
+private:
+  bool startHost();
+  void send(const QByteArray& message);
+  void connectHost();
+  void verifyHost(QLocalSocket* socket);
+  void readMessages();
+  void handleMessage(const QByteArray& payload);
+  void deliverEvents();
+  void presentFrame(quint32 generation, int buffer, QSize size, int bytesPerLine, int format);
+  void hostFinished();
+  void checkHost();
+
+private:
+  QLocalServer  m_server;
+  QLocalSocket* m_socket{ nullptr };
+  QProcess      m_process;
+  // Passed to the started host, which sends it back to prove it is the peer.
+  QByteArray    m_token;
+  QByteArray    m_readBuffer;
+  QByteArray    m_pending; // sent once the host connects
+  bool          m_stopping{ false };
+
+  EventListener m_listener;
+
+  // Frames refer to the memory of their generation, which lives as long as they do.
+  std::shared_ptr<QSharedMemory> m_memory;
+  quint32                        m_generation{ 0 };
+  QSize                          m_size;
+  double                         m_devicePixelRatio{ 1.0 };
+  QImage                         m_frame;
+  int                            m_frameBuffer{ -1 };
+
+  // Sent again to a restarted host.
+  QByteArray m_resizeMessage;
+  QByteArray m_loadMessage;
+  int        m_restarts{ 0 };
+
+  QTimer        m_watchdog;
+  QElapsedTimer m_lastPong;
+  bool          m_responsive{ true };
+
+  // The element read in progress, replies to earlier reads that timed out are dropped.
+  quint32                            m_lastRequest{ 0 };
+  quint32                            m_awaitedRequest{ 0 };
+  bool                               m_replied{ false };
+  std::string                        m_reply;
+  std::map<std::string, std::string> m_elements;
+
+  // Events received during an element read, delivered once it is done.
+  std::vector<std::array<QByteArray, 3>> m_queuedEvents;
+  bool                                   m_deliveryScheduled{ false };
+};
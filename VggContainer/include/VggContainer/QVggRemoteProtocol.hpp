@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QtEndian>
+
+// Messages between QVggRemoteContainer and the VggRenderHost process over a local socket. Every
+// message is its size, 32 bit big endian, followed by the message type and its fields written
+// with QDataStream.
+namespace QVggRemoteProtocol
+{
+
+enum Message : quint8
+{
+  // to the host
+  Load,           // QByteArray filePath, designDocSchemaFilePath, layoutDocSchemaFilePath
+  Resize,         // int width, height, double devicePixelRatio, QString memoryKey,
+                  // quint32 generation
+  Input,          // QByteArray UEvent
+  UpdateElements, // QList<QByteArray> ids, patches, applied together
+  GetElement,     // quint32 request, QByteArray id
+  ReleaseFrame,   // quint32 generation, int buffer
+  Ping,
+
+  // to the application
+  Hello,   // QByteArray token, the first message, connections without the token are closed
+  Loaded,  // bool result
+  Frame,   // quint32 generation, int buffer, width, height, bytesPerLine, format
+  Event,   // QByteArray type, targetId, targetPath
+  Element, // quint32 request, QByteArray element
+  Pong,
+};
+
+// The shared memory of a generation holds two frames, the host renders into the one the
+// application released.
+constexpr int FRAME_BUFFERS = 2;
+
+template<typename... Fields>
+QByteArray message(Message type, const Fields&... fields)
+{
+  QByteArray payload;
+  {
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << static_cast<quint8>(type);
+    (stream << ... << fields);
+  }
+
+  QByteArray framed(sizeof(quint32), Qt::Uninitialized);
+  qToBigEndian<quint32>(payload.size(), framed.data());
+  return framed + payload;
+}
+
+// Moves the first complete message of buffer to payload.
+inline bool takeMessage(QByteArray& buffer, QByteArray& payload)
+{
+  if (buffer.size() < static_cast<int>(sizeof(quint32)))
+  {
+    return false;
+  }
+
+  const auto size = qFromBigEndian<quint32>(buffer.constData());
+  if (static_cast<quint32>(buffer.size()) - sizeof(quint32) < size)
+  {
+    return false;
+  }
+
+  payload = buffer.mid(sizeof(quint32), size);
+  buffer.remove(0, sizeof(quint32) + size);
+  return true;
+}
+
+} // namespace QVggRemoteProtocol
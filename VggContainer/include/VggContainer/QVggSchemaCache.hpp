@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include <mutex>
+
+// Process wide record of documents that passed schema validation, shared by all containers.
+// Schemas are fingerprinted once per process (and again only when they change on disk), documents
+// are identified by a hash of their content, so an unchanged document is validated only once.
+class QVggSchemaCache
+{
+public:
+  static QVggSchemaCache& instance();
+
+  // Returns an empty key when no schema is given or a file cannot be read.
+  QByteArray documentKey(
+    const QString& filePath,
+    const char*    designDocSchemaFilePath,
+    const char*    layoutDocSchemaFilePath);
+
+  bool isValidated(const QByteArray& key);
+  void setValidated(const QByteArray& key);
+
+  // When disabled, every load is validated by the runtime.
+  void setFastValidationEnabled(bool enabled);
+  bool isFastValidationEnabled();
+
+  void clear();
+
+private:
+  QVggSchemaCache() = default;
+
+  QByteArray schemaFingerprint(const char* schemaFilePath);
+
+private:
+  struct SchemaEntry
+  {
+    QDateTime  lastModified;
+    qint64     size{ 0 };
+    QByteArray hash;
+  };
+
+  std::mutex                  m_lock;
+  QHash<QString, SchemaEntry> m_schemas;
+  QSet<QByteArray>            m_validatedDocuments;
+  bool                        m_fastValidationEnabled{ true };
+};
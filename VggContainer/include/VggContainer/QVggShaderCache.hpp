@@ -0,0 +1,38 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+
+class QOpenGLContext;
+
+// On-disk cache of compiled GPU programs shared by all containers and kept across runs.
+//
+// The cache is stored by the OpenGL driver (Mesa including llvmpipe, NVIDIA) and tagged with the GL
+// vendor, renderer and version strings. When they change, the stale cache is dropped on the next
+// start.
+class QVggShaderCache
+{
+public:
+  // Must be called before the application object is created, the platform plugin may load the
+  // OpenGL driver, which reads the cache location only once. Set the application name first when
+  // the path depends on it. An empty path leaves the driver defaults untouched.
+  static void setDirectory(const QString& path);
+
+  // Records the driver of the current context, called by the containers once a context exists.
+  static void validate(QOpenGLContext* context);
+};
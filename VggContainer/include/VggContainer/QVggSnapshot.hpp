@@ -0,0 +1,42 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+
+// Copies part of a rendered frame, scaled, straight from the framebuffer. The region is scaled by
+// one linear blit on the GPU and only the scaled pixels are read back, so thumbnails cost little
+// more than their own size. Without framebuffer blits, the region is read and scaled on the CPU.
+class QVggSnapshot
+{
+public:
+  // Called with the context current. source nullptr is the default framebuffer of the context.
+  // rect is in pixels of the source from its top-left corner, empty for all of it. Rows of GL
+  // framebuffers start at the bottom, pass bottomUp false for sources that start at the top.
+  static QImage grab(
+    QOpenGLContext*           context,
+    QOpenGLFramebufferObject* source,
+    const QSize&              sourceSize,
+    const QRect&              rect,
+    double                    scale,
+    bool                      bottomUp = true);
+};
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QPoint>
+#include <QRegion>
+
+#include <cstdint>
+#include <map>
+
+class QPainter;
+
+// Pieces of rendered frames kept by their position on the canvas, so panning back over content
+// that was shown before needs no rendering.
+//
+// Frames are cut into square tiles of the canvas, whose origin is at offset in the frame. Tiles are
+// evicted least recently used first once the cache exceeds its memory cap. Not thread safe.
+class QVggTileCache
+{
+public:
+  explicit QVggTileCache(qint64 memoryCapBytes = 256 << 20, int tileSize = 256);
+
+  void   setMemoryCap(qint64 bytes);
+  qint64 memoryCap() const;
+  qint64 memoryUsage() const;
+
+  // Copies the frame into the tiles it overlaps.
+  void insert(const QImage& frame, QPoint offset);
+
+  // Whether the cached tiles hold every pixel of a frame of the size.
+  bool covers(QSize size, QPoint offset) const;
+
+  // Whether the frame equals the cached tiles where they overlap, checked on every eighth row.
+  // A mismatch means the canvas changed or moved differently than expected.
+  bool matches(const QImage& frame, QPoint offset) const;
+
+  // Draws the cached tiles visible in a frame, uncovered pixels are left untouched.
+  void draw(QPainter& painter, QSize size, QPoint offset);
+
+  void clear();
+
+private:
+  struct Tile
+  {
+    QImage   image;
+    QRegion  valid; // in canvas coordinates
+    uint64_t lastUse;
+  };
+  using Key = std::pair<int, int>; // column, row
+
+  QRect tileRect(const Key& key) const;
+  // Tiles overlapping rect, in canvas coordinates.
+  QRect tileRange(const QRect& rect) const;
+  void  evict();
+
+private:
+  std::map<Key, Tile> m_tiles;
+  qint64              m_memoryCap;
+  qint64              m_memoryUsage{ 0 };
+  int                 m_tileSize;
+  uint64_t            m_useCounter{ 0 };
+};
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VGG/Event.hpp"
+
+#include <QPointF>
+#include <QSizeF>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class QNativeGestureEvent;
+class QTouchEvent;
+
+// Collects touch points and pinch/rotate gestures between two frames. take() turns them into
+// one finger event per changed touch point carrying its latest position, a single
+// VGG_MULTIGESTURE with the transform accumulated over the frame, and mouse events for the
+// primary touch point, so taps keep working as clicks. Events are added on the GUI thread and
+// taken by the dispatch tick on any thread.
+class QVggTouchBatch
+{
+public:
+  // Positions are in the coordinates of the container, whose size normalizes them.
+  bool add(QTouchEvent* event, const QSizeF& size);
+  bool add(QNativeGestureEvent* event, const QSizeF& size);
+
+  // Ends every touch point without a click, e.g. when the touch grab is taken away.
+  void cancel();
+
+  // Appends the events of the frame and starts the next one.
+  void take(std::vector<UEvent>& events);
+
+private:
+  struct TouchPoint
+  {
+    std::int64_t id;
+    QPointF      position;
+    QPointF      sentPosition;
+    float        pressure;
+    bool         pressed;
+    bool         moved;
+    bool         released;
+    bool         canceled;
+  };
+
+  TouchPoint& touchPoint(std::int64_t id, const QPointF& position);
+  void        cancelPoints();
+  void        appendFingerEvents(std::vector<UEvent>& events);
+  void        appendPrimaryEvents(std::vector<UEvent>& events);
+  void        appendGestureEvent(std::vector<UEvent>& events);
+
+private:
+  std::mutex              m_mutex;
+  std::vector<TouchPoint> m_points;
+  QSizeF                  m_size;
+
+  std::int64_t m_primaryId{ -1 };
+  bool         m_primaryPressed{ false };
+
+  // Transform of native gestures accumulated over the frame.
+  double  m_gestureScale{ 1.0 };
+  double  m_gestureRotation{ 0.0 };
+  QPointF m_gestureCenter;
+  bool    m_hasGesture{ false };
+
+  // Spread and angle of the touch points at the last frame, for pinching on touchscreens.
+  std::size_t m_lastPointCount{ 0 };
+  double      m_lastSpread{ 0.0 };
+  double      m_lastAngle{ 0.0 };
+};
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VggContainer/QVggDocumentAccess.hpp"
+
+#include <memory>
+
+// Groups element updates of a container, they are applied together when the transaction commits,
+// explicitly or when it goes out of scope. Patches of the same element are merged, so each element
+// is updated once, and a frame never shows part of the updates.
+//
+//   {
+//     auto transaction = vggContainer.transaction();
+//     button.setValue("/style/fills/0/color/alpha", 0.5);
+//     count.setValue("/content", "1");
+//   }
+class QVggTransaction
+{
+public:
+  explicit QVggTransaction(std::shared_ptr<QVggDocumentAccess> access);
+  ~QVggTransaction();
+
+  QVggTransaction(const QVggTransaction&) = delete;
+  QVggTransaction& operator=(const QVggTransaction&) = delete;
+
+  void commit();
+
+private:
+  std::shared_ptr<QVggDocumentAccess> m_access;
+};
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Container time driven by the application instead of the 16 ms timers. advance() reports how
+// many dispatch ticks fall into the interval, the container runs them back to back, so frame
+// sequences render as fast as the CPU allows and the same calls always see the same ticks. The
+// runtime keeps its wall clock for animations and timers.
+class QVggVirtualClock
+{
+public:
+  explicit QVggVirtualClock(double tickIntervalMs = 16.0);
+
+  // Moves the clock forward and returns the number of ticks passed, remainders carry over.
+  int advance(double ms);
+
+  double elapsed() const;
+  double tickInterval() const;
+
+private:
+  double m_tickInterval;
+  double m_elapsed{ 0 };
+  double m_nextTick;
+};
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggArchive.hpp"
+
+#include <QDir>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#ifdef VGG_CONTAINER_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+
+constexpr quint32 K_END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+constexpr quint32 K_CENTRAL_DIRECTORY_HEADER_SIGNATURE = 0x02014b50;
+constexpr quint32 K_LOCAL_FILE_HEADER_SIGNATURE = 0x04034b50;
+constexpr int     K_LOCAL_FILE_HEADER_SIZE = 30;
+constexpr int     K_END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+constexpr int     K_CENTRAL_DIRECTORY_HEADER_SIZE = 46;
+constexpr int     K_MAX_ZIP_COMMENT_SIZE = 0xffff;
+constexpr quint16 K_METHOD_STORED = 0;
+constexpr quint16 K_METHOD_DEFLATED = 8;
+
+const QString K_EVENT_LISTENERS_FILE_NAME = QStringLiteral("event_listeners.json");
+
+quint16 readU16(const char* p)
+{
+  auto u = reinterpret_cast<const uchar*>(p);
+  return static_cast<quint16>(u[0] | (u[1] << 8));
+}
+
+quint32 readU32(const char* p)
+{
+  auto u = reinterpret_cast<const uchar*>(p);
+  return static_cast<quint32>(u[0]) | (static_cast<quint32>(u[1]) << 8) |
+         (static_cast<quint32>(u[2]) << 16) | (static_cast<quint32>(u[3]) << 24);
+}
+
+QByteArray inflateRaw(const QByteArray& data, quint32 size)
+{
+#ifdef VGG_CONTAINER_HAS_ZLIB
+  QByteArray result(static_cast<int>(size), Qt::Uninitialized);
+
+  z_stream stream{};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+  {
+    return {};
+  }
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(result.data());
+  stream.avail_out = static_cast<uInt>(result.size());
+
+  const auto status = inflate(&stream, Z_FINISH);
+  inflateEnd(&stream);
+
+  if (status != Z_STREAM_END || stream.total_out != size)
+  {
+    return {};
+  }
+  return result;
+#else
+  Q_UNUSED(data);
+  Q_UNUSED(size);
+  return {};
+#endif
+}
+
+} // namespace
+
+QVggArchive::QVggArchive(const QString& filePath)
+  : m_filePath{ filePath }
+  , m_isDirectory{ QFileInfo(filePath).isDir() }
+  , m_isValid{ false }
+{
+  if (m_isDirectory)
+  {
+    readDirectory();
+    m_isValid = true;
+  }
+  else
+  {
+    m_isValid = readZipDirectory();
+  }
+}
+
+bool QVggArchive::isValid() const
+{
+  return m_isValid;
+}
+
+bool QVggArchive::isDirectory() const
+{
+  return m_isDirectory;
+}
+
+const QStringList& QVggArchive::entries() const
+{
+  return m_entries;
+}
+
+bool QVggArchive::contains(const QString& name) const
+{
+  return m_entries.contains(name);
+}
+
+bool QVggArchive::hasScripts() const
+{
+  for (const auto& entry : m_entries)
+  {
+    if (
+      entry == K_EVENT_LISTENERS_FILE_NAME || entry.endsWith(QStringLiteral(".mjs")) ||
+      entry.endsWith(QStringLiteral(".js")))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+QByteArray QVggArchive::read(const QString& name) const
+{
+  if (m_isDirectory)
+  {
+    QFile file{ QDir{ m_filePath }.filePath(name) };
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      return {};
+    }
+    return file.readAll();
+  }
+
+  auto it = m_zipEntries.constFind(name);
+  if (it == m_zipEntries.constEnd())
+  {
+    return {};
+  }
+  if (it->size == 0)
+  {
+    return QByteArray("", 0);
+  }
+
+  QFile file{ m_filePath };
+  if (!file.open(QIODevice::ReadOnly) || !file.seek(it->localHeaderOffset))
+  {
+    return {};
+  }
+
+  const auto header = file.read(K_LOCAL_FILE_HEADER_SIZE);
+  if (
+    header.size() != K_LOCAL_FILE_HEADER_SIZE ||
+    readU32(header.constData()) != K_LOCAL_FILE_HEADER_SIGNATURE)
+  {
+    return {};
+  }
+
+  const auto nameLength = readU16(header.constData() + 26);
+  const auto extraLength = readU16(header.constData() + 28);
+  if (!file.seek(it->localHeaderOffset + K_LOCAL_FILE_HEADER_SIZE + nameLength + extraLength))
+  {
+    return {};
+  }
+
+  const auto data = file.read(it->compressedSize);
+  if (data.size() != static_cast<int>(it->compressedSize))
+  {
+    return {};
+  }
+
+  switch (it->method)
+  {
+    case K_METHOD_STORED:
+      return data;
+    case K_METHOD_DEFLATED:
+      return inflateRaw(data, it->size);
+    default:
+      return {};
+  }
+}
+
+bool QVggArchive::extractTo(const QString& directoryPath) const
+{
+  QDir directory{ directoryPath };
+  for (const auto& entry : m_entries)
+  {
+    if (QDir::isAbsolutePath(entry) || entry.split(QLatin1Char('/')).contains(QStringLiteral("..")))
+    {
+      return false;
+    }
+
+    const auto content = read(entry);
+    if (content.isNull())
+    {
+      return false;
+    }
+
+    const auto filePath = directory.filePath(entry);
+    if (!directory.mkpath(QFileInfo(filePath).path()))
+    {
+      return false;
+    }
+
+    QFile file{ filePath };
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+quint64 QVggArchive::stamp(const QString& name) const
+{
+  if (m_isDirectory)
+  {
+    const QFileInfo info{ QDir{ m_filePath }.filePath(name) };
+    return (static_cast<quint64>(info.lastModified().toMSecsSinceEpoch()) << 20) ^
+           static_cast<quint64>(info.size());
+  }
+
+  auto it = m_zipEntries.constFind(name);
+  if (it == m_zipEntries.constEnd())
+  {
+    return 0;
+  }
+  return (static_cast<quint64>(it->crc) << 32) | it->size;
+}
+
+void QVggArchive::readDirectory()
+{
+  QDir         root{ m_filePath };
+  QDirIterator it{ m_filePath, QDir::Files, QDirIterator::Subdirectories };
+  while (it.hasNext())
+  {
+    m_entries.append(root.relativeFilePath(it.next()));
+  }
+}
+
+// Only the central directory is read, entry data stays on disk. Zip64 archives are not supported.
+bool QVggArchive::readZipDirectory()
+{
+  QFile file{ m_filePath };
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  const auto fileSize = file.size();
+  if (fileSize < K_END_OF_CENTRAL_DIRECTORY_SIZE)
+  {
+    return false;
+  }
+
+  const auto tailSize =
+    std::min<qint64>(fileSize, K_END_OF_CENTRAL_DIRECTORY_SIZE + K_MAX_ZIP_COMMENT_SIZE);
+  file.seek(fileSize - tailSize);
+  const auto tail = file.read(tailSize);
+
+  int eocd = -1;
+  for (int i = tail.size() - K_END_OF_CENTRAL_DIRECTORY_SIZE; i >= 0; --i)
+  {
+    if (readU32(tail.constData() + i) == K_END_OF_CENTRAL_DIRECTORY_SIGNATURE)
+    {
+      eocd = i;
+      break;
+    }
+  }
+  if (eocd < 0)
+  {
+    return false;
+  }
+
+  const auto entryCount = readU16(tail.constData() + eocd + 10);
+  const auto directorySize = readU32(tail.constData() + eocd + 12);
+  const auto directoryOffset = readU32(tail.constData() + eocd + 16);
+  if (static_cast<qint64>(directoryOffset) + directorySize > fileSize)
+  {
+    return false;
+  }
+
+  file.seek(directoryOffset);
+  const auto directory = file.read(directorySize);
+
+  int offset = 0;
+  for (int i = 0; i < entryCount; ++i)
+  {
+    if (offset + K_CENTRAL_DIRECTORY_HEADER_SIZE > directory.size())
+    {
+      return false;
+    }
+
+    const auto header = directory.constData() + offset;
+    if (readU32(header) != K_CENTRAL_DIRECTORY_HEADER_SIGNATURE)
+    {
+      return false;
+    }
+
+    const auto method = readU16(header + 10);
+    const auto crc = readU32(header + 16);
+    const auto compressedSize = readU32(header + 20);
+    const auto size = readU32(header + 24);
+    const auto nameLength = readU16(header + 28);
+    const auto extraLength = readU16(header + 30);
+    const auto commentLength = readU16(header + 32);
+    const auto localHeaderOffset = readU32(header + 42);
+    if (offset + K_CENTRAL_DIRECTORY_HEADER_SIZE + nameLength > directory.size())
+    {
+      return false;
+    }
+
+    const auto name = QString::fromUtf8(header + K_CENTRAL_DIRECTORY_HEADER_SIZE, nameLength);
+    if (!name.endsWith(QLatin1Char('/')))
+    {
+      m_entries.append(name);
+      m_zipEntries.insert(name, ZipEntry{ localHeaderOffset, crc, compressedSize, size, method });
+    }
+
+    offset += K_CENTRAL_DIRECTORY_HEADER_SIZE + nameLength + extraLength + commentLength;
+  }
+
+  return true;
+}
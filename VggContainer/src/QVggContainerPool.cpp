@@ -0,0 +1,156 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggContainerPool.hpp"
+#include "VggContainer/QVggEnvironment.hpp"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <algorithm>
+
+QVggContainerPool& QVggContainerPool::instance()
+{
+  static QVggContainerPool s_instance;
+
+  // Pooled containers must not outlive the environment, which is torn down on quit.
+  static const auto s_connection = QObject::connect(
+    QCoreApplication::instance(),
+    &QCoreApplication::aboutToQuit,
+    &s_instance,
+    &QVggContainerPool::clear);
+  Q_UNUSED(s_connection);
+
+  return s_instance;
+}
+
+void QVggContainerPool::prepare(int count)
+{
+  m_targetCount = std::max(count, 0);
+  schedule();
+}
+
+void QVggContainerPool::prepare(
+  const std::string& filePath,
+  int                count,
+  const char*        designDocSchemaFilePath,
+  const char*        layoutDocSchemaFilePath)
+{
+  m_pendingLoads[document(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath)] +=
+    std::max(count, 0);
+  schedule();
+}
+
+std::unique_ptr<VGG::QtContainer> QVggContainerPool::take()
+{
+  if (m_containers.empty())
+  {
+    return std::make_unique<VGG::QtContainer>();
+  }
+
+  auto container = std::move(m_containers.back());
+  m_containers.pop_back();
+  schedule();
+  return container;
+}
+
+std::unique_ptr<VGG::QtContainer> QVggContainerPool::take(
+  const std::string& filePath,
+  const char*        designDocSchemaFilePath,
+  const char*        layoutDocSchemaFilePath)
+{
+  auto it = m_loadedContainers.find(
+    document(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath));
+  if (it == m_loadedContainers.end())
+  {
+    return nullptr;
+  }
+
+  auto container = std::move(it->second.back());
+  it->second.pop_back();
+  if (it->second.empty())
+  {
+    m_loadedContainers.erase(it);
+  }
+  return container;
+}
+
+QVggContainerPool::TDocument QVggContainerPool::document(
+  const std::string& filePath,
+  const char*        designDocSchemaFilePath,
+  const char*        layoutDocSchemaFilePath)
+{
+  return { filePath,
+           designDocSchemaFilePath ? designDocSchemaFilePath : "",
+           layoutDocSchemaFilePath ? layoutDocSchemaFilePath : "" };
+}
+
+void QVggContainerPool::clear()
+{
+  m_targetCount = 0;
+  m_pendingLoads.clear();
+  m_containers.clear();
+  m_loadedContainers.clear();
+}
+
+void QVggContainerPool::schedule()
+{
+  if (m_scheduled)
+  {
+    return;
+  }
+
+  const auto needsContainers = static_cast<int>(m_containers.size()) < m_targetCount;
+  if (!needsContainers && m_pendingLoads.empty())
+  {
+    return;
+  }
+
+  m_scheduled = true;
+  QTimer::singleShot(0, this, &QVggContainerPool::createNext);
+}
+
+void QVggContainerPool::createNext()
+{
+  m_scheduled = false;
+
+  if (!m_pendingLoads.empty())
+  {
+    auto       it = m_pendingLoads.begin();
+    const auto key = it->first;
+    if (--it->second <= 0)
+    {
+      m_pendingLoads.erase(it);
+    }
+
+    const auto& [filePath, designSchema, layoutSchema] = key;
+    QVggEnvironment::setUpFor(filePath);
+    auto container = std::make_unique<VGG::QtContainer>();
+    if (container->load(
+          filePath,
+          designSchema.empty() ? nullptr : designSchema.c_str(),
+          layoutSchema.empty() ? nullptr : layoutSchema.c_str()))
+    {
+      m_loadedContainers[key].push_back(std::move(container));
+    }
+  }
+  else if (static_cast<int>(m_containers.size()) < m_targetCount)
+  {
+    m_containers.push_back(std::make_unique<VGG::QtContainer>());
+  }
+
+  schedule();
+}
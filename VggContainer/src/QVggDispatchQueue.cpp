@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggDispatchQueue.hpp"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+void QVggDispatchQueue::setBudget(double budgetMs)
+{
+  m_budgetNs = static_cast<std::int64_t>(std::max(budgetMs, 0.0) * 1e6);
+}
+
+double QVggDispatchQueue::budget() const
+{
+  return m_budgetNs / 1e6;
+}
+
+void QVggDispatchQueue::setBudgetSuspended(bool suspended)
+{
+  m_budgetSuspended = suspended;
+}
+
+std::int64_t QVggDispatchQueue::effectiveBudgetNs() const
+{
+  return m_budgetSuspended ? 0 : m_budgetNs.load();
+}
+
+void QVggDispatchQueue::post(const UEvent& evt)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_input.push_back(evt);
+}
+
+bool QVggDispatchQueue::isEmpty() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_input.empty();
+}
+
+void QVggDispatchQueue::drain(const std::function<void(UEvent& evt)>& onEvent)
+{
+  for (;;)
+  {
+    UEvent evt;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (m_input.empty())
+      {
+        return;
+      }
+      evt = m_input.front();
+      m_input.pop_front();
+    }
+    onEvent(evt);
+  }
+}
+
+void QVggDispatchQueue::run(
+  const std::function<void(UEvent& evt)>& onEvent,
+  const std::function<void()>&            dispatch)
+{
+  const auto    budgetNs = effectiveBudgetNs();
+  QElapsedTimer timer;
+  timer.start();
+
+  for (;;)
+  {
+    UEvent evt;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (m_input.empty() || (budgetNs > 0 && timer.nsecsElapsed() >= budgetNs))
+      {
+        break;
+      }
+      evt = m_input.front();
+      m_input.pop_front();
+    }
+    onEvent(evt);
+  }
+
+  dispatch();
+
+  const auto                  elapsedNs = timer.nsecsElapsed();
+  std::lock_guard<std::mutex> lock(m_lock);
+  ++m_stats.dispatches;
+  m_stats.lastDispatchMs = elapsedNs / 1e6;
+  m_stats.maxDispatchMs = std::max(m_stats.maxDispatchMs, m_stats.lastDispatchMs);
+  if (budgetNs > 0 && elapsedNs > budgetNs)
+  {
+    ++m_stats.overruns;
+  }
+}
+
+bool QVggDispatchQueue::deliver(
+  QVggEventQueue&                                          events,
+  const std::function<void(QVggEventQueue::Event& event)>& handle)
+{
+  const auto    budgetNs = effectiveBudgetNs();
+  QElapsedTimer timer;
+  timer.start();
+
+  QVggEventQueue::Event event;
+  while (budgetNs <= 0 || timer.nsecsElapsed() < budgetNs)
+  {
+    if (!events.pop(event))
+    {
+      return true;
+    }
+    handle(event);
+  }
+  return events.size() == 0;
+}
+
+QVggDispatchStats QVggDispatchQueue::stats(const QVggEventQueue& events) const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  auto                        stats = m_stats;
+  stats.inputQueueDepth = static_cast<qint64>(m_input.size());
+  stats.eventQueueDepth = static_cast<qint64>(events.size());
+  stats.overflowedEvents = static_cast<qint64>(events.overflowed());
+  return stats;
+}
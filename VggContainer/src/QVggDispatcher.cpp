@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggDispatcher.hpp"
+
+QVggDispatcher::QVggDispatcher(Task task, std::chrono::milliseconds interval)
+  : m_task{ std::move(task) }
+  , m_interval{ interval }
+  , m_thread{ &QVggDispatcher::run, this }
+{
+}
+
+QVggDispatcher::~QVggDispatcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stopped = true;
+  }
+  m_wakeUp.notify_one();
+  m_thread.join();
+}
+
+void QVggDispatcher::wake()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_woken = true;
+  }
+  m_wakeUp.notify_one();
+}
+
+void QVggDispatcher::run()
+{
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_lock);
+      m_wakeUp.wait_for(lock, m_interval, [this]() { return m_woken || m_stopped; });
+      if (m_stopped)
+      {
+        return;
+      }
+      m_woken = false;
+    }
+
+    m_task();
+  }
+}
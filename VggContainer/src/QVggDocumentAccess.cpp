@@ -0,0 +1,251 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggDocumentAccess.hpp"
+
+#include <QJsonDocument>
+
+namespace
+{
+
+// Combines two merge patches into one that has the effect of applying both in order.
+void mergePatch(QJsonObject& target, const QJsonObject& patch)
+{
+  for (auto it = patch.begin(); it != patch.end(); ++it)
+  {
+    auto existing = target.find(it.key());
+    if (existing != target.end() && existing->isObject() && it->isObject())
+    {
+      auto object = existing->toObject();
+      mergePatch(object, it->toObject());
+      *existing = object;
+    }
+    else
+    {
+      target.insert(it.key(), *it);
+    }
+  }
+}
+
+std::string toString(const QJsonObject& patch)
+{
+  return QJsonDocument(patch).toJson(QJsonDocument::Compact).toStdString();
+}
+
+} // namespace
+
+QVggDocumentAccess::QVggDocumentAccess(Invoker invoker)
+  : m_invoker{ std::move(invoker) }
+{
+}
+
+QVggDocumentAccess::QVggDocumentAccess(Forwarder forwarder)
+  : m_forwarder{ std::move(forwarder) }
+{
+}
+
+void QVggDocumentAccess::detach()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_invoker = nullptr;
+  m_forwarder = {};
+  m_callsEnded.wait(lock, [this]() { return m_calls == 0; });
+}
+
+bool QVggDocumentAccess::beginCall(Invoker& invoker, Forwarder& forwarder)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_invoker && !m_forwarder.getElement && !m_forwarder.updateElements)
+  {
+    return false;
+  }
+
+  invoker = m_invoker;
+  forwarder = m_forwarder;
+  ++m_calls;
+  return true;
+}
+
+void QVggDocumentAccess::endCall()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    --m_calls;
+  }
+  m_callsEnded.notify_all();
+}
+
+std::string QVggDocumentAccess::getElement(const std::string& id)
+{
+  // Event handlers may access elements while a forwarded reply is awaited.
+  Invoker   invoker;
+  Forwarder forwarder;
+  if (!beginCall(invoker, forwarder))
+  {
+    return {};
+  }
+
+  std::string element;
+  if (forwarder.getElement)
+  {
+    element = forwarder.getElement(id);
+  }
+  else if (invoker)
+  {
+    invoker([&id, &element](VGG::ISdk& sdk) { element = sdk.getElement(id); });
+  }
+  endCall();
+  return element;
+}
+
+std::uint64_t QVggDocumentAccess::updateElement(const std::string& id, const std::string& patch)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_batchDepth == 0)
+    {
+      const auto revision = raiseRevision(id);
+      lock.unlock();
+      apply({ { id, patch } });
+      return revision;
+    }
+  }
+
+  return updateElement(id, QJsonDocument::fromJson(QByteArray::fromStdString(patch)).object());
+}
+
+std::uint64_t QVggDocumentAccess::updateElement(const std::string& id, const QJsonObject& patch)
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  const auto                   revision = raiseRevision(id);
+  if (m_batchDepth == 0)
+  {
+    lock.unlock();
+    apply({ { id, toString(patch) } });
+    return revision;
+  }
+
+  auto it = m_pendingIndex.find(id);
+  if (it == m_pendingIndex.end())
+  {
+    m_pendingIndex.emplace(id, m_pending.size());
+    m_pending.emplace_back(id, patch);
+  }
+  else
+  {
+    mergePatch(m_pending[it->second].second, patch);
+  }
+  return revision;
+}
+
+std::uint64_t QVggDocumentAccess::revision(const std::string& id)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  const auto                  it = m_revisions.find(id);
+  return it == m_revisions.end() ? m_loadRevision : it->second;
+}
+
+std::uint64_t QVggDocumentAccess::raiseRevision(const std::string& id)
+{
+  return m_revisions[id] = ++m_revision;
+}
+
+void QVggDocumentAccess::beginBatch()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  ++m_batchDepth;
+}
+
+void QVggDocumentAccess::resetBatch()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_batchDepth = 0;
+  m_pending.clear();
+  m_pendingIndex.clear();
+  m_loadRevision = ++m_revision;
+  m_revisions.clear();
+}
+
+void QVggDocumentAccess::commitBatch()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  if (m_batchDepth == 0 || --m_batchDepth > 0)
+  {
+    return;
+  }
+
+  auto pending = std::move(m_pending);
+  m_pending.clear();
+  m_pendingIndex.clear();
+  lock.unlock();
+
+  Forwarder::Updates updates;
+  updates.reserve(pending.size());
+  for (const auto& [id, patch] : pending)
+  {
+    updates.emplace_back(id, toString(patch));
+  }
+  apply(updates);
+}
+
+void QVggDocumentAccess::apply(const Forwarder::Updates& updates)
+{
+  if (updates.empty())
+  {
+    return;
+  }
+
+  Invoker   invoker;
+  Forwarder forwarder;
+  if (!beginCall(invoker, forwarder))
+  {
+    return;
+  }
+
+  if (forwarder.updateElements)
+  {
+    forwarder.updateElements(updates);
+  }
+  else if (invoker)
+  {
+    // One pass under the container lock, a frame sees either none or all of the updates.
+    invoker(
+      [&updates](VGG::ISdk& sdk)
+      {
+        for (const auto& [id, patch] : updates)
+        {
+          sdk.updateElement(id, patch);
+        }
+      });
+  }
+  endCall();
+}
+
+void QVggDocumentAccess::invoke(const std::function<void(VGG::ISdk& sdk)>& function)
+{
+  Invoker   invoker;
+  Forwarder forwarder;
+  if (!beginCall(invoker, forwarder))
+  {
+    return;
+  }
+
+  if (invoker)
+  {
+    invoker(function);
+  }
+  endCall();
+}
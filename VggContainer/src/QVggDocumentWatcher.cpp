@@ -0,0 +1,253 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggDocumentWatcher.hpp"
+#include "VggContainer/QVggArchive.hpp"
+#include "VggContainer/QVggElement.hpp"
+
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace
+{
+
+const QString K_DESIGN_FILE_NAME = QStringLiteral("design.json");
+const QString K_ID = QStringLiteral("id");
+const QString K_CHILD_OBJECTS = QStringLiteral("childObjects");
+const QString K_FRAMES = QStringLiteral("frames");
+
+// Saving usually writes the file in several steps, wait until it settles.
+constexpr int K_DEBOUNCE_INTERVAL = 200;
+
+struct ElementInfo
+{
+  QJsonObject properties; // without children
+  QStringList children;
+  QJsonArray  childObjects;
+};
+
+using ElementIndex = QHash<QString, ElementInfo>;
+
+// Returns false if an element id is not unique.
+bool indexElements(const QJsonArray& elements, ElementIndex& index, QStringList& ids)
+{
+  for (const auto& value : elements)
+  {
+    auto       element = value.toObject();
+    const auto id = element.value(K_ID).toString();
+    if (id.isEmpty() || index.contains(id))
+    {
+      return false;
+    }
+    ids.append(id);
+
+    ElementInfo info;
+    const auto  children = element.take(K_CHILD_OBJECTS).toArray();
+    info.properties = element;
+    info.childObjects = children;
+    index.insert(id, {});
+
+    if (!indexElements(children, index, info.children))
+    {
+      return false;
+    }
+    index.insert(id, info);
+  }
+  return true;
+}
+
+// Appends the patches of the elements and their descendants in document order, so a parent
+// replacing its children comes before any of them. Returns false if a reload is needed.
+bool diffElements(
+  const QStringList&           ids,
+  const ElementIndex&          fromIndex,
+  const ElementIndex&          toIndex,
+  QVggDocumentWatcher::Change& change)
+{
+  for (const auto& id : ids)
+  {
+    const auto element = toIndex.constFind(id);
+    const auto old = fromIndex.constFind(id);
+    if (old == fromIndex.constEnd())
+    {
+      continue; // added, sent with the children of its parent
+    }
+
+    QJsonObject patch;
+    if (
+      old->properties != element->properties &&
+      !QVggElement::makeMergePatch(old->properties, element->properties, patch))
+    {
+      return false;
+    }
+    // Elements are added, removed or moved by replacing the children of their parents, which
+    // carry their descendants as well.
+    const auto replaced = old->children != element->children;
+    if (replaced)
+    {
+      patch.insert(K_CHILD_OBJECTS, element->childObjects);
+    }
+    if (!patch.isEmpty())
+    {
+      change.elementPatches.emplace_back(
+        id.toStdString(),
+        QJsonDocument(patch).toJson(QJsonDocument::Compact).toStdString());
+    }
+
+    if (!replaced && !diffElements(element->children, fromIndex, toIndex, change))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+QVggDocumentWatcher::Change diff(const QJsonObject& from, const QJsonObject& to)
+{
+  QVggDocumentWatcher::Change change;
+  change.needsReload = true;
+
+  auto fromRest = from, toRest = to;
+  fromRest.remove(K_FRAMES);
+  toRest.remove(K_FRAMES);
+  if (fromRest != toRest)
+  {
+    return change;
+  }
+
+  ElementIndex fromIndex, toIndex;
+  QStringList  fromFrames, toFrames;
+  if (
+    !indexElements(from.value(K_FRAMES).toArray(), fromIndex, fromFrames) ||
+    !indexElements(to.value(K_FRAMES).toArray(), toIndex, toFrames) || fromFrames != toFrames ||
+    !diffElements(toFrames, fromIndex, toIndex, change))
+  {
+    return change;
+  }
+
+  change.needsReload = false;
+  return change;
+}
+
+} // namespace
+
+QVggDocumentWatcher::QVggDocumentWatcher(ChangeHandler handler)
+  : m_handler{ std::move(handler) }
+{
+  m_debounce.setSingleShot(true);
+  m_debounce.setInterval(K_DEBOUNCE_INTERVAL);
+  QObject::connect(&m_debounce, &QTimer::timeout, [this]() { onFileChanged(); });
+  QObject::connect(
+    &m_watcher,
+    &QFileSystemWatcher::fileChanged,
+    [this](const QString&) { m_debounce.start(); });
+  QObject::connect(
+    &m_watcher,
+    &QFileSystemWatcher::directoryChanged,
+    [this](const QString&) { m_debounce.start(); });
+}
+
+void QVggDocumentWatcher::watch(const QString& filePath)
+{
+  stop();
+
+  m_filePath = filePath;
+  readDocument(m_design, m_stamps);
+
+  if (QFileInfo(filePath).isDir())
+  {
+    m_watcher.addPath(filePath);
+    for (auto it = m_stamps.constBegin(); it != m_stamps.constEnd(); ++it)
+    {
+      m_watcher.addPath(filePath + QLatin1Char('/') + it.key());
+    }
+    m_watcher.addPath(filePath + QLatin1Char('/') + K_DESIGN_FILE_NAME);
+  }
+  else
+  {
+    m_watcher.addPath(filePath);
+  }
+}
+
+void QVggDocumentWatcher::stop()
+{
+  m_debounce.stop();
+  if (!m_watcher.files().isEmpty())
+  {
+    m_watcher.removePaths(m_watcher.files());
+  }
+  if (!m_watcher.directories().isEmpty())
+  {
+    m_watcher.removePaths(m_watcher.directories());
+  }
+  m_filePath.clear();
+  m_design = {};
+  m_stamps.clear();
+}
+
+const QString& QVggDocumentWatcher::filePath() const
+{
+  return m_filePath;
+}
+
+void QVggDocumentWatcher::onFileChanged()
+{
+  // Editors often replace the file instead of writing it, which drops it from the watcher.
+  if (!QFileInfo::exists(m_filePath))
+  {
+    return;
+  }
+  if (!m_watcher.files().contains(m_filePath) && !m_watcher.directories().contains(m_filePath))
+  {
+    m_watcher.addPath(m_filePath);
+  }
+
+  QJsonObject             design;
+  QHash<QString, quint64> stamps;
+  readDocument(design, stamps);
+  if (design.isEmpty())
+  {
+    return;
+  }
+
+  auto change = stamps == m_stamps ? diff(m_design, design) : Change{ true, {} };
+  m_design = design;
+  m_stamps = stamps;
+
+  if (change.needsReload || !change.elementPatches.empty())
+  {
+    m_handler(change);
+  }
+}
+
+void QVggDocumentWatcher::readDocument(QJsonObject& design, QHash<QString, quint64>& stamps) const
+{
+  QVggArchive archive{ m_filePath };
+  if (!archive.isValid())
+  {
+    return;
+  }
+
+  design = QJsonDocument::fromJson(archive.read(K_DESIGN_FILE_NAME)).object();
+  for (const auto& entry : archive.entries())
+  {
+    if (entry != K_DESIGN_FILE_NAME)
+    {
+      stamps.insert(entry, archive.stamp(entry));
+    }
+  }
+}
@@ -0,0 +1,604 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggElement.hpp"
+
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <vector>
+
+namespace
+{
+
+QJsonValue valueAt(const QJsonValue& root, const QStringList& tokens)
+{
+  auto node = root;
+  for (const auto& token : tokens)
+  {
+    if (node.isObject())
+    {
+      node = node.toObject().value(token);
+    }
+    else if (node.isArray())
+    {
+      bool       ok = false;
+      const auto index = token.toInt(&ok);
+      const auto array = node.toArray();
+      if (!ok || index < 0 || index >= array.size())
+      {
+        return QJsonValue(QJsonValue::Undefined);
+      }
+      node = array.at(index);
+    }
+    else
+    {
+      return QJsonValue(QJsonValue::Undefined);
+    }
+  }
+  return node;
+}
+
+// Missing objects on the way are created, "-" appends to an array. With insert, as by a JSON Patch
+// add, the parent must exist and a value at an array index is inserted before the existing item
+// instead of replacing it.
+bool setValueAt(
+  QJsonValue&        node,
+  const QStringList& tokens,
+  int                depth,
+  const QJsonValue&  value,
+  bool               insert = false)
+{
+  if (depth == tokens.size())
+  {
+    node = value;
+    return true;
+  }
+
+  const auto& token = tokens[depth];
+  if (node.isUndefined() || node.isNull())
+  {
+    if (insert)
+    {
+      return false;
+    }
+    node = QJsonObject();
+  }
+
+  if (node.isObject())
+  {
+    auto object = node.toObject();
+    auto child = object.value(token);
+    if (!setValueAt(child, tokens, depth + 1, value, insert))
+    {
+      return false;
+    }
+    object.insert(token, child);
+    node = object;
+    return true;
+  }
+
+  if (node.isArray())
+  {
+    auto       array = node.toArray();
+    bool       ok = token == QLatin1String("-");
+    const auto index = ok ? array.size() : token.toInt(&ok);
+    if (!ok || index < 0 || index > array.size())
+    {
+      return false;
+    }
+
+    if (insert && depth + 1 == tokens.size())
+    {
+      array.insert(index, value);
+      node = array;
+      return true;
+    }
+
+    auto child = index < array.size() ? array.at(index) : QJsonValue();
+    if (!setValueAt(child, tokens, depth + 1, value, insert))
+    {
+      return false;
+    }
+    if (index == array.size())
+    {
+      array.append(child);
+    }
+    else
+    {
+      array.replace(index, child);
+    }
+    node = array;
+    return true;
+  }
+
+  return false;
+}
+
+bool removeAt(QJsonValue& node, const QStringList& tokens, int depth)
+{
+  if (depth == tokens.size())
+  {
+    return false;
+  }
+
+  const auto& token = tokens[depth];
+  const auto  last = depth + 1 == tokens.size();
+  if (node.isObject())
+  {
+    auto object = node.toObject();
+    auto it = object.find(token);
+    if (it == object.end())
+    {
+      return false;
+    }
+    if (last)
+    {
+      object.erase(it);
+    }
+    else
+    {
+      auto child = it.value();
+      if (!removeAt(child, tokens, depth + 1))
+      {
+        return false;
+      }
+      it.value() = child;
+    }
+    node = object;
+    return true;
+  }
+
+  if (node.isArray())
+  {
+    auto       array = node.toArray();
+    bool       ok = false;
+    const auto index = token.toInt(&ok);
+    if (!ok || index < 0 || index >= array.size())
+    {
+      return false;
+    }
+    if (last)
+    {
+      array.removeAt(index);
+    }
+    else
+    {
+      auto child = array.at(index);
+      if (!removeAt(child, tokens, depth + 1))
+      {
+        return false;
+      }
+      array.replace(index, child);
+    }
+    node = array;
+    return true;
+  }
+
+  return false;
+}
+
+// RFC 7386, null removes a member.
+void applyMergePatch(QJsonObject& target, const QJsonObject& patch)
+{
+  for (auto it = patch.begin(); it != patch.end(); ++it)
+  {
+    if (it->isNull())
+    {
+      target.remove(it.key());
+    }
+    else if (it->isObject())
+    {
+      auto object = target.value(it.key()).toObject();
+      applyMergePatch(object, it->toObject());
+      target.insert(it.key(), object);
+    }
+    else
+    {
+      target.insert(it.key(), *it);
+    }
+  }
+}
+
+// The runtime merges objects of a patch into the element but replaces arrays, so the patch nests
+// objects down to the changed property or to the first array on the way, which is sent whole. An
+// object replacing an object is sent as their difference, so members it lacks are removed.
+bool makePatch(
+  const QJsonObject& from,
+  const QJsonObject& to,
+  const QStringList& tokens,
+  QJsonObject&       patch)
+{
+  QJsonValue oldNode = from;
+  QJsonValue newNode = to;
+  int        depth = 0;
+  while (depth < tokens.size() && newNode.isObject())
+  {
+    oldNode = oldNode.toObject().value(tokens[depth]);
+    newNode = newNode.toObject().value(tokens[depth]);
+    ++depth;
+  }
+
+  // a removed member is sent as null
+  auto value = newNode.isUndefined() ? QJsonValue(QJsonValue::Null) : newNode;
+  if (oldNode.isObject() && newNode.isObject())
+  {
+    QJsonObject difference;
+    if (!QVggElement::makeMergePatch(oldNode.toObject(), newNode.toObject(), difference))
+    {
+      return false;
+    }
+    value = difference;
+  }
+
+  for (int i = depth - 1; i >= 0; --i)
+  {
+    QJsonObject parent;
+    parent.insert(tokens[i], value);
+    value = parent;
+  }
+  patch = value.toObject();
+  return true;
+}
+
+// Whether makePatch() sends a whole array for the path.
+bool patchesArray(const QJsonObject& element, const QStringList& tokens)
+{
+  QJsonValue node = element;
+  int        depth = 0;
+  while (depth < tokens.size() && node.isObject())
+  {
+    node = node.toObject().value(tokens[depth]);
+    ++depth;
+  }
+  return depth < tokens.size() && node.isArray();
+}
+
+} // namespace
+
+QVggElement::QVggElement(std::shared_ptr<QVggDocumentAccess> access, std::string id)
+  : m_data{ std::make_shared<Data>() }
+{
+  m_data->access = std::move(access);
+  m_data->id = std::move(id);
+}
+
+bool QVggElement::isValid() const
+{
+  return m_data && !element().isEmpty();
+}
+
+const std::string& QVggElement::id() const
+{
+  static const std::string s_empty;
+  return m_data ? m_data->id : s_empty;
+}
+
+QJsonValue QVggElement::value(const QString& path) const
+{
+  QStringList tokens;
+  if (!m_data || !parsePath(path, tokens))
+  {
+    return QJsonValue(QJsonValue::Undefined);
+  }
+  return valueAt(element(), tokens);
+}
+
+double QVggElement::toDouble(const QString& path, double defaultValue) const
+{
+  return value(path).toDouble(defaultValue);
+}
+
+QString QVggElement::toString(const QString& path, const QString& defaultValue) const
+{
+  return value(path).toString(defaultValue);
+}
+
+bool QVggElement::toBool(const QString& path, bool defaultValue) const
+{
+  return value(path).toBool(defaultValue);
+}
+
+bool QVggElement::setValue(const QString& path, const QJsonValue& value)
+{
+  QStringList tokens;
+  if (!isValid() || !parsePath(path, tokens))
+  {
+    return false;
+  }
+
+  // Arrays are sent whole, a stale cache is read again so items changed elsewhere are not reverted.
+  if (patchesArray(m_data->element, tokens) && !isCurrent())
+  {
+    refresh();
+    if (!isValid())
+    {
+      return false;
+    }
+  }
+
+  QJsonValue  root = m_data->element;
+  QJsonObject patch;
+  if (
+    !setValueAt(root, tokens, 0, value) || !root.isObject() ||
+    !makePatch(m_data->element, root.toObject(), tokens, patch))
+  {
+    return false;
+  }
+  // the cache takes the patch as the runtime does, e.g. without members set to null
+  applyMergePatch(m_data->element, patch);
+
+  const auto current = isCurrent();
+  const auto revision = m_data->access->updateElement(m_data->id, patch);
+  if (current)
+  {
+    m_data->revision = revision;
+  }
+  return true;
+}
+
+bool QVggElement::applyPatch(const QJsonObject& mergePatch)
+{
+  if (!isValid())
+  {
+    return false;
+  }
+
+  applyMergePatch(m_data->element, mergePatch);
+  const auto current = isCurrent();
+  const auto revision = m_data->access->updateElement(m_data->id, mergePatch);
+  if (current)
+  {
+    m_data->revision = revision;
+  }
+  return true;
+}
+
+bool QVggElement::applyCborPatch(const QByteArray& mergePatch)
+{
+  QCborParserError error;
+  const auto       patch = QCborValue::fromCbor(mergePatch, &error);
+  if (error.error != QCborError::NoError || !patch.isMap())
+  {
+    return false;
+  }
+  return applyPatch(patch.toJsonValue().toObject());
+}
+
+bool QVggElement::applyJsonPatch(const QJsonArray& operations)
+{
+  if (!isValid())
+  {
+    return false;
+  }
+
+  // Arrays are sent whole, a stale cache is read again so items changed elsewhere are not reverted.
+  if (!isCurrent())
+  {
+    for (const auto& item : operations)
+    {
+      const auto  operation = item.toObject();
+      QStringList path;
+      QStringList from;
+      if (
+        (parsePath(operation.value(QLatin1String("path")).toString(), path) &&
+         patchesArray(m_data->element, path)) ||
+        (parsePath(operation.value(QLatin1String("from")).toString(), from) &&
+         patchesArray(m_data->element, from)))
+      {
+        refresh();
+        if (!isValid())
+        {
+          return false;
+        }
+        break;
+      }
+    }
+  }
+
+  QJsonValue               root = m_data->element;
+  std::vector<QStringList> changed;
+  for (const auto& item : operations)
+  {
+    const auto  operation = item.toObject();
+    const auto  op = operation.value(QLatin1String("op")).toString();
+    QStringList path;
+    QStringList from;
+    if (!parsePath(operation.value(QLatin1String("path")).toString(), path) || path.isEmpty())
+    {
+      return false;
+    }
+
+    auto ok = false;
+    if (op == QLatin1String("add"))
+    {
+      ok = setValueAt(root, path, 0, operation.value(QLatin1String("value")), true);
+    }
+    else if (op == QLatin1String("remove"))
+    {
+      ok = removeAt(root, path, 0);
+    }
+    else if (op == QLatin1String("replace"))
+    {
+      ok = !valueAt(root, path).isUndefined() &&
+           setValueAt(root, path, 0, operation.value(QLatin1String("value")));
+    }
+    else if (op == QLatin1String("test"))
+    {
+      ok = valueAt(root, path) == operation.value(QLatin1String("value"));
+    }
+    else if (op == QLatin1String("copy") || op == QLatin1String("move"))
+    {
+      if (!parsePath(operation.value(QLatin1String("from")).toString(), from) || from.isEmpty())
+      {
+        return false;
+      }
+      // a value cannot be moved into one of its own children
+      const auto intoItself = op == QLatin1String("move") && path.size() > from.size() &&
+                              path.mid(0, from.size()) == from;
+      const auto value = valueAt(root, from);
+      ok = !intoItself && !value.isUndefined() &&
+           (op == QLatin1String("copy") || removeAt(root, from, 0)) &&
+           setValueAt(root, path, 0, value, true);
+      if (op == QLatin1String("move"))
+      {
+        changed.push_back(from);
+      }
+    }
+
+    // all or nothing, a failed operation leaves the element unchanged
+    if (!ok)
+    {
+      return false;
+    }
+    if (op != QLatin1String("test"))
+    {
+      changed.push_back(path);
+    }
+  }
+
+  if (!root.isObject())
+  {
+    return false;
+  }
+
+  std::vector<QJsonObject> patches;
+  for (const auto& tokens : changed)
+  {
+    QJsonObject patch;
+    if (!makePatch(m_data->element, root.toObject(), tokens, patch))
+    {
+      return false;
+    }
+    patches.push_back(patch);
+  }
+  for (const auto& patch : patches)
+  {
+    applyMergePatch(m_data->element, patch);
+  }
+
+  // the access merges the patches into one update
+  const auto current = isCurrent();
+  m_data->access->beginBatch();
+  for (const auto& patch : patches)
+  {
+    const auto revision = m_data->access->updateElement(m_data->id, patch);
+    if (current)
+    {
+      m_data->revision = revision;
+    }
+  }
+  m_data->access->commitBatch();
+  return true;
+}
+
+QByteArray QVggElement::toCbor() const
+{
+  return QCborValue::fromJsonValue(toJson()).toCbor();
+}
+
+QJsonObject QVggElement::toJson() const
+{
+  return m_data ? element() : QJsonObject();
+}
+
+void QVggElement::refresh()
+{
+  if (m_data)
+  {
+    m_data->loaded = false;
+  }
+}
+
+bool QVggElement::makeMergePatch(const QJsonObject& from, const QJsonObject& to, QJsonObject& patch)
+{
+  for (auto it = from.constBegin(); it != from.constEnd(); ++it)
+  {
+    if (!to.contains(it.key()))
+    {
+      patch.insert(it.key(), QJsonValue::Null);
+    }
+  }
+
+  for (auto it = to.constBegin(); it != to.constEnd(); ++it)
+  {
+    const auto oldValue = from.value(it.key());
+    if (oldValue == it.value())
+    {
+      continue;
+    }
+    if (it.value().isNull())
+    {
+      return false;
+    }
+
+    if (oldValue.isObject() && it.value().isObject())
+    {
+      QJsonObject childPatch;
+      if (!makeMergePatch(oldValue.toObject(), it.value().toObject(), childPatch))
+      {
+        return false;
+      }
+      patch.insert(it.key(), childPatch);
+    }
+    else
+    {
+      patch.insert(it.key(), it.value());
+    }
+  }
+  return true;
+}
+
+bool QVggElement::parsePath(const QString& path, QStringList& tokens)
+{
+  tokens.clear();
+  if (path.isEmpty())
+  {
+    return true;
+  }
+  if (!path.startsWith(QLatin1Char('/')))
+  {
+    return false;
+  }
+
+  for (auto token : path.mid(1).split(QLatin1Char('/')))
+  {
+    token.replace(QLatin1String("~1"), QLatin1String("/"));
+    token.replace(QLatin1String("~0"), QLatin1String("~"));
+    tokens.append(token);
+  }
+  return true;
+}
+
+const QJsonObject& QVggElement::element() const
+{
+  if (!m_data->loaded)
+  {
+    // taken first, an update made meanwhile makes the cache stale rather than lost
+    m_data->revision = m_data->access->revision(m_data->id);
+    const auto json = m_data->access->getElement(m_data->id);
+    m_data->element = QJsonDocument::fromJson(QByteArray::fromStdString(json)).object();
+    // retried while the element does not exist, e.g. before the document is loaded
+    m_data->loaded = !m_data->element.isEmpty();
+  }
+  return m_data->element;
+}
+
+bool QVggElement::isCurrent() const
+{
+  return m_data->loaded && m_data->access->revision(m_data->id) == m_data->revision;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggArchive.hpp"
+#include "VggContainer/QVggLoadTimings.hpp"
+
+#include "VGG/Environment.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <mutex>
+
+namespace
+{
+
+std::mutex& getLock()
+{
+  static std::mutex s_lock;
+  return s_lock;
+}
+
+void setDefaultEnv(const char* name, const QByteArray& value)
+{
+  if (!qEnvironmentVariableIsSet(name))
+  {
+    qputenv(name, value);
+  }
+}
+
+bool& getIsSetUp()
+{
+  static bool s_isSetUp = false;
+  return s_isSetUp;
+}
+
+} // namespace
+
+void QVggEnvironment::setUp()
+{
+  std::lock_guard<std::mutex> lock(getLock());
+  if (getIsSetUp())
+  {
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  VGG::Environment::setUp();
+  QVggLoadTimings::recordEnvironmentSetUp(timer.nsecsElapsed() / 1e6);
+
+  getIsSetUp() = true;
+}
+
+void QVggEnvironment::setUpFor(const std::string& filePath)
+{
+  if (isSetUp() || !hasScripts(filePath))
+  {
+    return;
+  }
+
+  setUp();
+}
+
+void QVggEnvironment::tearDown()
+{
+  std::lock_guard<std::mutex> lock(getLock());
+  if (!getIsSetUp())
+  {
+    return;
+  }
+
+  VGG::Environment::tearDown();
+  getIsSetUp() = false;
+}
+
+bool QVggEnvironment::isSetUp()
+{
+  std::lock_guard<std::mutex> lock(getLock());
+  return getIsSetUp();
+}
+
+bool QVggEnvironment::hasScripts(const std::string& filePath)
+{
+  QVggArchive archive{ QString::fromStdString(filePath) };
+
+  // Let the runtime decide about documents we cannot inspect.
+  return !archive.isValid() || archive.hasScripts();
+}
+
+void QVggEnvironment::setUpSoftwareRendering(int threads)
+{
+  if (threads <= 0)
+  {
+    threads = QThread::idealThreadCount();
+  }
+
+  // Windows loads opengl32sw, the llvmpipe build shipped with Qt
+  QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+  setDefaultEnv("LIBGL_ALWAYS_SOFTWARE", "1");
+  setDefaultEnv("GALLIUM_DRIVER", "llvmpipe");
+  setDefaultEnv("LP_NUM_THREADS", QByteArray::number(threads));
+}
@@ -15,47 +15,242 @@
  */
 
 #include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggLoadTimings.hpp"
 
 #include "VGG/Keycode.hpp"
 
-#include <QApplication>
-
-#include <unordered_map>
+#include <QElapsedTimer>
+#include <QGuiApplication>
 
 namespace {
 
-#define VGG_RELEASED 0
-#define VGG_PRESSED 1
+// Qt key codes are sparse, so the translation tables are built at compile time as dense pages
+// for the Latin-1 keys and the 0x01000000 block holding most special keys. Keys outside both
+// pages are rare and looked up in the lists directly.
+
+struct KeyMapping {
+  int key;
+  int scancode;
+};
+
+struct KeyRange {
+  int firstKey;
+  int lastKey;
+  int firstScancode;
+};
+
+using TKeyPage = std::array<std::uint16_t, 256>;
+
+constexpr int K_LATIN1_PAGE = 0x00000000;
+constexpr int K_SPECIAL_PAGE = 0x01000000;
+
+constexpr KeyRange K_KEY_RANGES[] = {
+  {Qt::Key_A, Qt::Key_Z, VGG_SCANCODE_A},
+  {Qt::Key_1, Qt::Key_9, VGG_SCANCODE_1},
+  {Qt::Key_F1, Qt::Key_F12, VGG_SCANCODE_F1},
+  {Qt::Key_F13, Qt::Key_F24, VGG_SCANCODE_F13},
+};
+
+constexpr KeyMapping K_KEYS[] = {
+  {Qt::Key_0, VGG_SCANCODE_0},
+  {Qt::Key_Return, VGG_SCANCODE_RETURN},
+  {Qt::Key_Enter, VGG_SCANCODE_KP_ENTER},
+  {Qt::Key_Escape, VGG_SCANCODE_ESCAPE},
+  {Qt::Key_Backspace, VGG_SCANCODE_BACKSPACE},
+  {Qt::Key_Tab, VGG_SCANCODE_TAB},
+  {Qt::Key_Backtab, VGG_SCANCODE_TAB},
+  {Qt::Key_Space, VGG_SCANCODE_SPACE},
+
+  {Qt::Key_Minus, VGG_SCANCODE_MINUS},
+  {Qt::Key_Equal, VGG_SCANCODE_EQUALS},
+  {Qt::Key_BracketLeft, VGG_SCANCODE_LEFTBRACKET},
+  {Qt::Key_BracketRight, VGG_SCANCODE_RIGHTBRACKET},
+  {Qt::Key_Backslash, VGG_SCANCODE_BACKSLASH},
+  {Qt::Key_Semicolon, VGG_SCANCODE_SEMICOLON},
+  {Qt::Key_Apostrophe, VGG_SCANCODE_APOSTROPHE},
+  {Qt::Key_QuoteLeft, VGG_SCANCODE_GRAVE},
+  {Qt::Key_Comma, VGG_SCANCODE_COMMA},
+  {Qt::Key_Period, VGG_SCANCODE_PERIOD},
+  {Qt::Key_Slash, VGG_SCANCODE_SLASH},
+  {Qt::Key_currency, VGG_SCANCODE_CURRENCYUNIT},
+  {Qt::Key_ParenLeft, VGG_SCANCODE_KP_LEFTPAREN},
+  {Qt::Key_ParenRight, VGG_SCANCODE_KP_RIGHTPAREN},
+
+  {Qt::Key_CapsLock, VGG_SCANCODE_CAPSLOCK},
+  {Qt::Key_Print, VGG_SCANCODE_PRINTSCREEN},
+  {Qt::Key_ScreenSaver, VGG_SCANCODE_PRINTSCREEN},
+  {Qt::Key_ScrollLock, VGG_SCANCODE_SCROLLLOCK},
+  {Qt::Key_Pause, VGG_SCANCODE_PAUSE},
+  {Qt::Key_Insert, VGG_SCANCODE_INSERT},
+  {Qt::Key_Home, VGG_SCANCODE_HOME},
+  {Qt::Key_PageUp, VGG_SCANCODE_PAGEUP},
+  {Qt::Key_Delete, VGG_SCANCODE_DELETE},
+  {Qt::Key_End, VGG_SCANCODE_END},
+  {Qt::Key_PageDown, VGG_SCANCODE_PAGEDOWN},
+  {Qt::Key_Right, VGG_SCANCODE_RIGHT},
+  {Qt::Key_Left, VGG_SCANCODE_LEFT},
+  {Qt::Key_Down, VGG_SCANCODE_DOWN},
+  {Qt::Key_Up, VGG_SCANCODE_UP},
+  {Qt::Key_NumLock, VGG_SCANCODE_NUMLOCKCLEAR},
+
+  // Qt does not tell left from right modifiers, they are reported as the left key.
+  {Qt::Key_Shift, VGG_SCANCODE_LSHIFT},
+  {Qt::Key_Control, VGG_SCANCODE_LCTRL},
+  {Qt::Key_Alt, VGG_SCANCODE_LALT},
+  {Qt::Key_Meta, VGG_SCANCODE_LGUI},
+  {Qt::Key_AltGr, VGG_SCANCODE_RALT},
+  {Qt::Key_Super_L, VGG_SCANCODE_LGUI},
+  {Qt::Key_Super_R, VGG_SCANCODE_RGUI},
+  {Qt::Key_Mode_switch, VGG_SCANCODE_MODE},
+
+  {Qt::Key_Execute, VGG_SCANCODE_EXECUTE},
+  {Qt::Key_Help, VGG_SCANCODE_HELP},
+  {Qt::Key_Menu, VGG_SCANCODE_MENU},
+  {Qt::Key_Select, VGG_SCANCODE_SELECT},
+  {Qt::Key_Stop, VGG_SCANCODE_STOP},
+  {Qt::Key_Redo, VGG_SCANCODE_AGAIN},
+  {Qt::Key_Undo, VGG_SCANCODE_UNDO},
+  {Qt::Key_Cut, VGG_SCANCODE_CUT},
+  {Qt::Key_Copy, VGG_SCANCODE_COPY},
+  {Qt::Key_Paste, VGG_SCANCODE_PASTE},
+  {Qt::Key_Find, VGG_SCANCODE_FIND},
+  {Qt::Key_VolumeMute, VGG_SCANCODE_MUTE},
+  {Qt::Key_VolumeUp, VGG_SCANCODE_VOLUMEUP},
+  {Qt::Key_VolumeDown, VGG_SCANCODE_VOLUMEDOWN},
+  {Qt::Key_SysReq, VGG_SCANCODE_SYSREQ},
+  {Qt::Key_Cancel, VGG_SCANCODE_CANCEL},
+  {Qt::Key_Clear, VGG_SCANCODE_CLEAR},
+  {Qt::Key_PowerOff, VGG_SCANCODE_POWER},
+
+  {Qt::Key_MediaNext, VGG_SCANCODE_AUDIONEXT},
+  {Qt::Key_MediaPrevious, VGG_SCANCODE_AUDIOPREV},
+  {Qt::Key_MediaStop, VGG_SCANCODE_AUDIOSTOP},
+  {Qt::Key_MediaPlay, VGG_SCANCODE_AUDIOPLAY},
+  {Qt::Key_WWW, VGG_SCANCODE_WWW},
+  {Qt::Key_LaunchMail, VGG_SCANCODE_MAIL},
+  {Qt::Key_Calendar, VGG_SCANCODE_CALCULATOR},
+  {Qt::Key_Calculator, VGG_SCANCODE_CALCULATOR},
+  {Qt::Key_Search, VGG_SCANCODE_AC_SEARCH},
+  {Qt::Key_HomePage, VGG_SCANCODE_AC_HOME},
+  {Qt::Key_Back, VGG_SCANCODE_AC_BACK},
+  {Qt::Key_Forward, VGG_SCANCODE_AC_FORWARD},
+  {Qt::Key_Refresh, VGG_SCANCODE_AC_REFRESH},
+  {Qt::Key_Favorites, VGG_SCANCODE_AC_BOOKMARKS},
+  {Qt::Key_MonBrightnessDown, VGG_SCANCODE_BRIGHTNESSDOWN},
+  {Qt::Key_MonBrightnessUp, VGG_SCANCODE_BRIGHTNESSUP},
+  {Qt::Key_Display, VGG_SCANCODE_DISPLAYSWITCH},
+  {Qt::Key_KeyboardLightOnOff, VGG_SCANCODE_KBDILLUMTOGGLE},
+  {Qt::Key_KeyboardBrightnessDown, VGG_SCANCODE_KBDILLUMDOWN},
+  {Qt::Key_KeyboardBrightnessUp, VGG_SCANCODE_KBDILLUMUP},
+  {Qt::Key_Eject, VGG_SCANCODE_EJECT},
+  {Qt::Key_Sleep, VGG_SCANCODE_SLEEP},
+  {Qt::Key_AudioRewind, VGG_SCANCODE_AUDIOREWIND},
+  {Qt::Key_AudioForward, VGG_SCANCODE_AUDIOFASTFORWARD},
+  {Qt::Key_ApplicationLeft, VGG_SCANCODE_SOFTLEFT},
+  {Qt::Key_ApplicationRight, VGG_SCANCODE_SOFTRIGHT},
+  {Qt::Key_Call, VGG_SCANCODE_CALL},
+  {Qt::Key_Hangup, VGG_SCANCODE_ENDCALL},
+};
+
+// Used instead of the keys above when the event carries Qt::KeypadModifier.
+constexpr KeyRange K_KEYPAD_RANGES[] = {
+  {Qt::Key_1, Qt::Key_9, VGG_SCANCODE_KP_1},
+};
+
+constexpr KeyMapping K_KEYPAD_KEYS[] = {
+  {Qt::Key_0, VGG_SCANCODE_KP_0},
+  {Qt::Key_Slash, VGG_SCANCODE_KP_DIVIDE},
+  {Qt::Key_Asterisk, VGG_SCANCODE_KP_MULTIPLY},
+  {Qt::Key_Minus, VGG_SCANCODE_KP_MINUS},
+  {Qt::Key_Plus, VGG_SCANCODE_KP_PLUS},
+  {Qt::Key_Enter, VGG_SCANCODE_KP_ENTER},
+  {Qt::Key_Period, VGG_SCANCODE_KP_PERIOD},
+  {Qt::Key_Comma, VGG_SCANCODE_KP_COMMA},
+  {Qt::Key_Equal, VGG_SCANCODE_KP_EQUALS},
+};
+
+constexpr bool isInPage(int page, int key) {
+  return key >= page && key < page + static_cast<int>(TKeyPage().size());
+}
 
-auto &getKeyMap() {
-  static std::unordered_map<int, EVGGScancode> s_keyMap;
-  return s_keyMap;
+template <std::size_t RANGES, std::size_t KEYS>
+constexpr TKeyPage makePage(int page, const KeyRange (&ranges)[RANGES],
+                            const KeyMapping (&keys)[KEYS]) {
+  TKeyPage result{};
+  for (const auto &range : ranges) {
+    for (int key = range.firstKey; key <= range.lastKey; ++key) {
+      if (isInPage(page, key)) {
+        result[key - page] =
+            static_cast<std::uint16_t>(range.firstScancode + key - range.firstKey);
+      }
+    }
+  }
+  for (const auto &mapping : keys) {
+    if (isInPage(page, mapping.key)) {
+      result[mapping.key - page] = static_cast<std::uint16_t>(mapping.scancode);
+    }
+  }
+  return result;
 }
 
-auto &getKeyState() {
-  static uint8_t s_keyState[VGG_NUM_SCANCODES];
-  return s_keyState;
+template <std::size_t RANGES, std::size_t KEYS>
+constexpr int findScancode(int key, const KeyRange (&ranges)[RANGES],
+                           const KeyMapping (&keys)[KEYS]) {
+  for (const auto &range : ranges) {
+    if (key >= range.firstKey && key <= range.lastKey) {
+      return range.firstScancode + key - range.firstKey;
+    }
+  }
+  for (const auto &mapping : keys) {
+    if (mapping.key == key) {
+      return mapping.scancode;
+    }
+  }
+  return VGG_SCANCODE_UNKNOWN;
+}
+
+constexpr TKeyPage K_LATIN1_KEYS = makePage(K_LATIN1_PAGE, K_KEY_RANGES, K_KEYS);
+constexpr TKeyPage K_SPECIAL_KEYS = makePage(K_SPECIAL_PAGE, K_KEY_RANGES, K_KEYS);
+constexpr TKeyPage K_LATIN1_KEYPAD_KEYS =
+    makePage(K_LATIN1_PAGE, K_KEYPAD_RANGES, K_KEYPAD_KEYS);
+constexpr TKeyPage K_SPECIAL_KEYPAD_KEYS =
+    makePage(K_SPECIAL_PAGE, K_KEYPAD_RANGES, K_KEYPAD_KEYS);
+
+static_assert(K_LATIN1_KEYS[Qt::Key_A] == VGG_SCANCODE_A, "letters must be mapped");
+static_assert(K_SPECIAL_KEYS[Qt::Key_Escape - K_SPECIAL_PAGE] == VGG_SCANCODE_ESCAPE,
+              "special keys must be mapped");
+
+thread_local QVggKeyboardState *t_currentKeyboardState = nullptr;
+
+} // namespace
+
+QVggKeyboardState::Scope::Scope(QVggKeyboardState &state)
+    : m_previous(t_currentKeyboardState) {
+  t_currentKeyboardState = &state;
 }
 
-int vggSendKeyboardKey(uint8_t state, EVGGScancode scancode) {
-  if (scancode == VGG_SCANCODE_UNKNOWN || scancode >= VGG_NUM_SCANCODES) {
-    return 0;
+QVggKeyboardState::Scope::~Scope() { t_currentKeyboardState = m_previous; }
+
+void QVggKeyboardState::apply(const UEvent &event) {
+  m_keyEvent = event.type == VGG_KEYDOWN || event.type == VGG_KEYUP;
+  if (!m_keyEvent) {
+    return;
   }
 
-  switch (state) {
-  case VGG_PRESSED:
-  case VGG_RELEASED:
-    break;
-  default:
-    return 0;
+  const auto scancode = event.key.keysym.scancode;
+  if (scancode > VGG_SCANCODE_UNKNOWN && scancode < VGG_NUM_SCANCODES) {
+    m_keys[scancode] = event.type == VGG_KEYDOWN ? 1 : 0;
   }
+  m_modState = static_cast<EVGGKeymod>(event.key.keysym.mod);
+}
 
-  getKeyState()[scancode] = state;
+QVggKeyboardState *QVggKeyboardState::current() { return t_currentKeyboardState; }
 
-  return 0;
-}
+bool QVggKeyboardState::isKeyEvent() const { return m_keyEvent; }
 
-} // namespace
+EVGGKeymod QVggKeyboardState::modState() const { return m_modState; }
+
+uint8_t *QVggKeyboardState::keys() { return m_keys.data(); }
 
 EVGGKeymod
 QVggEventAdapter::toVggModState(Qt::KeyboardModifiers keyboardModifiers) {
@@ -77,8 +272,32 @@ QVggEventAdapter::toVggModState(Qt::KeyboardModifiers keyboardModifiers) {
   return static_cast<EVGGKeymod>(keyMod);
 }
 
+EVGGScancode
+QVggEventAdapter::toVggScancode(int key, Qt::KeyboardModifiers keyboardModifiers) {
+  const bool keypad = keyboardModifiers.testFlag(Qt::KeypadModifier);
+  const int index = key & 0xff;
+
+  int scancode = VGG_SCANCODE_UNKNOWN;
+  if (isInPage(K_LATIN1_PAGE, key)) {
+    scancode = keypad ? K_LATIN1_KEYPAD_KEYS[index] : 0;
+    scancode = scancode ? scancode : K_LATIN1_KEYS[index];
+  } else if (isInPage(K_SPECIAL_PAGE, key)) {
+    scancode = keypad ? K_SPECIAL_KEYPAD_KEYS[index] : 0;
+    scancode = scancode ? scancode : K_SPECIAL_KEYS[index];
+  } else {
+    scancode = findScancode(key, K_KEY_RANGES, K_KEYS);
+  }
+
+  return static_cast<EVGGScancode>(scancode);
+}
+
 EVGGKeymod QVggEventAdapter::getModState() {
-  return toVggModState(QApplication::keyboardModifiers());
+  // Mouse and touch events carry no modifiers of their own, ask Qt for the live ones.
+  auto state = QVggKeyboardState::current();
+  if (state && state->isKeyEvent()) {
+    return state->modState();
+  }
+  return toVggModState(QGuiApplication::keyboardModifiers());
 }
 
 uint8_t *QVggEventAdapter::getKeyboardState(int *nums) {
@@ -86,251 +305,46 @@ uint8_t *QVggEventAdapter::getKeyboardState(int *nums) {
     *nums = VGG_NUM_SCANCODES;
   }
 
-  return getKeyState();
+  if (auto state = QVggKeyboardState::current()) {
+    return state->keys();
+  }
+
+  // Outside of a container nothing is pressed.
+  thread_local std::array<uint8_t, VGG_NUM_SCANCODES> s_released;
+  s_released.fill(0);
+  return s_released.data();
 }
 
 UEvent QVggEventAdapter::keyPressEvent(QKeyEvent *event) {
-  auto code = getKeyMap()[event->key()];
-  vggSendKeyboardKey(VGG_PRESSED, code);
+  const auto scancode = toVggScancode(event->key(), event->modifiers());
 
   UEvent vggEvent;
   vggEvent.key.type = VGG_KEYDOWN;
   vggEvent.key.keysym.mod = toVggModState(event->modifiers());
-  vggEvent.key.keysym.sym = toVggKeyCode(event->key());
+  vggEvent.key.keysym.scancode = scancode;
+  vggEvent.key.keysym.sym = EventManager::getKeyFromScancode(scancode);
 
   return vggEvent;
 }
 
 UEvent QVggEventAdapter::keyReleaseEvent(QKeyEvent *event) {
-  auto code = getKeyMap()[event->key()];
-  vggSendKeyboardKey(VGG_RELEASED, code);
+  const auto scancode = toVggScancode(event->key(), event->modifiers());
 
   UEvent vggEvent;
   vggEvent.key.type = VGG_KEYUP;
   vggEvent.key.keysym.mod = toVggModState(event->modifiers());
-  vggEvent.key.keysym.sym = toVggKeyCode(event->key());
+  vggEvent.key.keysym.scancode = scancode;
+  vggEvent.key.keysym.sym = EventManager::getKeyFromScancode(scancode);
 
   return vggEvent;
 }
 
 void QVggEventAdapter::setup() {
+  QElapsedTimer timer;
+  timer.start();
+
   auto eventApi = std::make_unique<QVggEventAdapter>();
   EventManager::registerEventAPI(std::move(eventApi));
 
-  auto &keyMap = getKeyMap();
-
-  for (int k = Qt::Key_A, v = VGG_SCANCODE_A; k <= Qt::Key_Z; ++k, ++v) {
-    keyMap[k] = static_cast<EVGGScancode>(v);
-  }
-
-  for (int k = Qt::Key_1, v = VGG_SCANCODE_1; k <= Qt::Key_9; ++k, ++v) {
-    keyMap[k] = static_cast<EVGGScancode>(v);
-  }
-  keyMap[Qt::Key_0] = VGG_SCANCODE_0;
-
-  keyMap[Qt::Key_Return] = VGG_SCANCODE_RETURN;
-  keyMap[Qt::Key_Escape] = VGG_SCANCODE_ESCAPE;
-  keyMap[Qt::Key_Backspace] = VGG_SCANCODE_BACKSPACE;
-  keyMap[Qt::Key_Tab] = VGG_SCANCODE_TAB;
-  keyMap[Qt::Key_Space] = VGG_SCANCODE_SPACE;
-
-  keyMap[Qt::Key_Minus] = VGG_SCANCODE_MINUS;
-  keyMap[Qt::Key_Equal] = VGG_SCANCODE_EQUALS;
-  keyMap[Qt::Key_BracketLeft] = VGG_SCANCODE_LEFTBRACKET;
-  keyMap[Qt::Key_BracketRight] = VGG_SCANCODE_RIGHTBRACKET;
-  keyMap[Qt::Key_Backslash] = VGG_SCANCODE_BACKSLASH;
-
-  // keyMap[Qt::Key_] = VGG_SCANCODE_NONUSHASH;
-
-  keyMap[Qt::Key_Semicolon] = VGG_SCANCODE_SEMICOLON;
-  keyMap[Qt::Key_Apostrophe] = VGG_SCANCODE_APOSTROPHE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_GRAVE;
-  keyMap[Qt::Key_Comma] = VGG_SCANCODE_COMMA;
-  keyMap[Qt::Key_Period] = VGG_SCANCODE_PERIOD;
-  keyMap[Qt::Key_Slash] = VGG_SCANCODE_SLASH;
-
-  keyMap[Qt::Key_CapsLock] = VGG_SCANCODE_CAPSLOCK;
-  for (int k = Qt::Key_F1, v = VGG_SCANCODE_F1; k <= Qt::Key_F12; ++k, ++v) {
-    keyMap[k] = static_cast<EVGGScancode>(v);
-  }
-
-  keyMap[Qt::Key_ScreenSaver] = VGG_SCANCODE_PRINTSCREEN;
-  keyMap[Qt::Key_ScrollLock] = VGG_SCANCODE_SCROLLLOCK;
-  keyMap[Qt::Key_Pause] = VGG_SCANCODE_PAUSE;
-  keyMap[Qt::Key_Insert] = VGG_SCANCODE_INSERT;
-  keyMap[Qt::Key_Home] = VGG_SCANCODE_HOME;
-  keyMap[Qt::Key_PageUp] = VGG_SCANCODE_PAGEUP;
-  keyMap[Qt::Key_Delete] = VGG_SCANCODE_DELETE;
-  keyMap[Qt::Key_End] = VGG_SCANCODE_END;
-  keyMap[Qt::Key_PageDown] = VGG_SCANCODE_PAGEDOWN;
-  keyMap[Qt::Key_Right] = VGG_SCANCODE_RIGHT;
-  keyMap[Qt::Key_Left] = VGG_SCANCODE_LEFT;
-  keyMap[Qt::Key_Down] = VGG_SCANCODE_DOWN;
-  keyMap[Qt::Key_Up] = VGG_SCANCODE_UP;
-  keyMap[Qt::Key_NumLock] = VGG_SCANCODE_NUMLOCKCLEAR;
-
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_DIVIDE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MULTIPLY;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MINUS;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_PLUS;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_ENTER;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_1;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_2;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_3;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_4;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_5;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_6;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_7;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_8;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_9;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_0;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_PERIOD;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_NONUSBACKSLASH;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_APPLICATION;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_POWER;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_EQUALS;
-
-  for (int k = Qt::Key_F13, v = VGG_SCANCODE_F13; k <= Qt::Key_F24; ++k, ++v) {
-    keyMap[k] = static_cast<EVGGScancode>(v);
-  }
-
-  keyMap[Qt::Key_Execute] = VGG_SCANCODE_EXECUTE;
-  keyMap[Qt::Key_Help] = VGG_SCANCODE_HELP;
-  keyMap[Qt::Key_Menu] = VGG_SCANCODE_MENU;
-  keyMap[Qt::Key_Select] = VGG_SCANCODE_SELECT;
-  keyMap[Qt::Key_Stop] = VGG_SCANCODE_STOP;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AGAIN;
-  keyMap[Qt::Key_Undo] = VGG_SCANCODE_UNDO;
-  keyMap[Qt::Key_Cut] = VGG_SCANCODE_CUT;
-  keyMap[Qt::Key_Copy] = VGG_SCANCODE_COPY;
-  keyMap[Qt::Key_Paste] = VGG_SCANCODE_PASTE;
-  keyMap[Qt::Key_Find] = VGG_SCANCODE_FIND;
-  keyMap[Qt::Key_VolumeMute] = VGG_SCANCODE_MUTE;
-  keyMap[Qt::Key_VolumeUp] = VGG_SCANCODE_VOLUMEUP;
-  keyMap[Qt::Key_VolumeDown] = VGG_SCANCODE_VOLUMEDOWN;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_COMMA;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_EQUALSAS400;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL1;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL2;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL3;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL4;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL5;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL6;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL7;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL8;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_INTERNATIONAL9;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG1;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG2;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG3;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG4;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG5;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG6;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG7;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG8;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LANG9;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_ALTERASE;
-  keyMap[Qt::Key_SysReq] = VGG_SCANCODE_SYSREQ;
-  keyMap[Qt::Key_Cancel] = VGG_SCANCODE_CANCEL;
-  keyMap[Qt::Key_Clear] = VGG_SCANCODE_CLEAR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_PRIOR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_RETURN2;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_SEPARATOR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_OUT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_OPER;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_CLEARAGAIN;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_CRSEL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_EXSEL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_00;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_000;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_THOUSANDSSEPARATOR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_DECIMALSEPARATOR;
-  keyMap[Qt::Key_currency] = VGG_SCANCODE_CURRENCYUNIT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_CURRENCYSUBUNIT;
-  keyMap[Qt::Key_ParenLeft] = VGG_SCANCODE_KP_LEFTPAREN;
-  keyMap[Qt::Key_ParenRight] = VGG_SCANCODE_KP_RIGHTPAREN;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_LEFTBRACE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_RIGHTBRACE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_TAB;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_BACKSPACE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_A;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_B;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_C;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_D;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_E;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_F;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_XOR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_POWER;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_PERCENT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_LESS;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_GREATER;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_AMPERSAND;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_DBLAMPERSAND;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_VERTICALBAR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_DBLVERTICALBAR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_COLON;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_HASH;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_SPACE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_AT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_EXCLAM;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMSTORE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMRECALL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMCLEAR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMADD;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMSUBTRACT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMMULTIPLY;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_MEMDIVIDE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_PLUSMINUS;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_CLEAR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_CLEARENTRY;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_BINARY;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_OCTAL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_DECIMAL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_KP_HEXADECIMAL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LCTRL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LSHIFT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LALT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_LGUI;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_RCTRL;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_RSHIFT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_RALT;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_RGUI;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_MODE;
-  keyMap[Qt::Key_MediaNext] = VGG_SCANCODE_AUDIONEXT;
-  keyMap[Qt::Key_MediaPrevious] = VGG_SCANCODE_AUDIOPREV;
-  keyMap[Qt::Key_MediaStop] = VGG_SCANCODE_AUDIOSTOP;
-  keyMap[Qt::Key_MediaPlay] = VGG_SCANCODE_AUDIOPLAY;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AUDIOMUTE;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_MEDIASELECT;
-  keyMap[Qt::Key_WWW] = VGG_SCANCODE_WWW;
-  keyMap[Qt::Key_LaunchMail] = VGG_SCANCODE_MAIL;
-  keyMap[Qt::Key_Calendar] = VGG_SCANCODE_CALCULATOR;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_COMPUTER;
-  keyMap[Qt::Key_Search] = VGG_SCANCODE_AC_SEARCH;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_HOME;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_BACK;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_FORWARD;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_STOP;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_REFRESH;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_AC_BOOKMARKS;
-  keyMap[Qt::Key_MonBrightnessDown] = VGG_SCANCODE_BRIGHTNESSDOWN;
-  keyMap[Qt::Key_MonBrightnessUp] = VGG_SCANCODE_BRIGHTNESSUP;
-  keyMap[Qt::Key_Display] = VGG_SCANCODE_DISPLAYSWITCH;
-  keyMap[Qt::Key_KeyboardLightOnOff] = VGG_SCANCODE_KBDILLUMTOGGLE;
-  keyMap[Qt::Key_KeyboardBrightnessDown] = VGG_SCANCODE_KBDILLUMDOWN;
-  keyMap[Qt::Key_KeyboardBrightnessUp] = VGG_SCANCODE_KBDILLUMUP;
-  keyMap[Qt::Key_Eject] = VGG_SCANCODE_EJECT;
-  keyMap[Qt::Key_Sleep] = VGG_SCANCODE_SLEEP;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_APP1;
-  // keyMap[Qt::Key_] = VGG_SCANCODE_APP2;
-  keyMap[Qt::Key_AudioRewind] = VGG_SCANCODE_AUDIOREWIND;
-  keyMap[Qt::Key_AudioForward] = VGG_SCANCODE_AUDIOFASTFORWARD;
-  keyMap[Qt::Key_ApplicationLeft] = VGG_SCANCODE_SOFTLEFT;
-  keyMap[Qt::Key_ApplicationRight] = VGG_SCANCODE_SOFTRIGHT;
-  keyMap[Qt::Key_Call] = VGG_SCANCODE_CALL;
-  keyMap[Qt::Key_Hangup] = VGG_SCANCODE_ENDCALL;
-}
-
-EVGGKeyCode QVggEventAdapter::toVggKeyCode(int key) {
-  auto scanCode = getKeyMap()[key];
-  return EventManager::getKeyFromScancode(scanCode);
+  QVggLoadTimings::recordEventAdapterSetUp(timer.nsecsElapsed() / 1e6);
 }
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggEventQueue.hpp"
+
+// Each cell's sequence tells whether it is free for the push at that position or holds the event
+// for the pop at that position, see Dmitry Vyukov's bounded MPMC queue.
+QVggEventQueue::QVggEventQueue(std::size_t capacity)
+{
+  std::size_t size = 2;
+  while (size < capacity)
+  {
+    size *= 2;
+  }
+
+  m_cells.reset(new Cell[size]);
+  m_mask = size - 1;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+void QVggEventQueue::push(Event&& event)
+{
+  if (m_overflowSize.load(std::memory_order_acquire) == 0 && pushCell(event))
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_overflowLock);
+  m_overflow.push_back(std::move(event));
+  m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+  m_overflowed.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool QVggEventQueue::pop(Event& event)
+{
+  // Overflowing events were pushed after those in the ring.
+  if (popCell(event))
+  {
+    return true;
+  }
+  if (m_overflowSize.load(std::memory_order_acquire) == 0)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_overflowLock);
+  if (m_overflow.empty())
+  {
+    return false;
+  }
+  event = std::move(m_overflow.front());
+  m_overflow.pop_front();
+  m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+  return true;
+}
+
+// Moves from event only when it succeeds.
+bool QVggEventQueue::pushCell(Event& event)
+{
+  auto position = m_pushPosition.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    auto&      cell = m_cells[position & m_mask];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    const auto difference =
+      static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+    if (difference == 0)
+    {
+      if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        cell.event = std::move(event);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;
+    }
+    else
+    {
+      position = m_pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool QVggEventQueue::popCell(Event& event)
+{
+  auto position = m_popPosition.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    auto&      cell = m_cells[position & m_mask];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    const auto difference =
+      static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+    if (difference == 0)
+    {
+      if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        event = std::move(cell.event);
+        cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;
+    }
+    else
+    {
+      position = m_popPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+std::size_t QVggEventQueue::size() const
+{
+  const auto pushed = m_pushPosition.load(std::memory_order_relaxed);
+  const auto popped = m_popPosition.load(std::memory_order_relaxed);
+  const auto overflow = m_overflowSize.load(std::memory_order_relaxed);
+  return (pushed > popped ? pushed - popped : 0) + overflow;
+}
+
+std::size_t QVggEventQueue::overflowed() const
+{
+  return m_overflowed.load(std::memory_order_relaxed);
+}
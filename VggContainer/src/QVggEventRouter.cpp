@@ -0,0 +1,125 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggEventRouter.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+bool startsWith(std::string_view text, std::string_view prefix)
+{
+  return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace
+
+int QVggEventRouter::subscribe(const std::string& type, const std::string& target, Handler handler)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  auto                        table = std::make_shared<Table>(*m_table);
+  auto&                       subscriptions = type.empty() ? table->anyType : table->byType[type];
+
+  const auto id = m_nextId++;
+  subscriptions.push_back({ id, target, std::move(handler) });
+  m_table = std::move(table);
+  return id;
+}
+
+void QVggEventRouter::unsubscribe(int subscription)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  auto                        table = std::make_shared<Table>(*m_table);
+
+  auto remove = [subscription](std::vector<Subscription>& subscriptions)
+  {
+    subscriptions.erase(
+      std::remove_if(
+        subscriptions.begin(),
+        subscriptions.end(),
+        [subscription](const Subscription& s) { return s.id == subscription; }),
+      subscriptions.end());
+  };
+  remove(table->anyType);
+  for (auto it = table->byType.begin(); it != table->byType.end();)
+  {
+    remove(it->second);
+    it = it->second.empty() ? table->byType.erase(it) : std::next(it);
+  }
+  m_table = std::move(table);
+}
+
+bool QVggEventRouter::isEmpty() const
+{
+  const auto current = table();
+  return current->byType.empty() && current->anyType.empty();
+}
+
+bool QVggEventRouter::route(
+  const std::string& type,
+  const std::string& targetId,
+  const std::string& targetPath)
+{
+  const auto      current = table();
+  const QVggEvent event{ type, targetId, targetPath };
+  bool            routed = false;
+
+  auto call = [&](const std::vector<Subscription>& subscriptions)
+  {
+    for (const auto& subscription : subscriptions)
+    {
+      if (subscription.matches(targetId, targetPath))
+      {
+        subscription.handler(event);
+        routed = true;
+      }
+    }
+  };
+
+  auto it = current->byType.find(type);
+  if (it != current->byType.end())
+  {
+    call(it->second);
+  }
+  call(current->anyType);
+  return routed;
+}
+
+std::shared_ptr<const QVggEventRouter::Table> QVggEventRouter::table() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_table;
+}
+
+bool QVggEventRouter::Subscription::matches(
+  std::string_view targetId,
+  std::string_view targetPath) const
+{
+  if (target.empty())
+  {
+    return true;
+  }
+
+  std::string_view pattern = target;
+  if (pattern.back() == '*')
+  {
+    pattern.remove_suffix(1);
+    return startsWith(targetId, pattern) || startsWith(targetPath, pattern);
+  }
+  return targetId == pattern || targetPath == pattern;
+}
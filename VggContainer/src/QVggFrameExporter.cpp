@@ -0,0 +1,368 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggFrameExporter.hpp"
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+bool hasPixelBuffers(QOpenGLContext* context)
+{
+  const auto version = context->format().version();
+  return version >= qMakePair(3, 0);
+}
+
+bool writeAll(int fd, const void* data, std::size_t size)
+{
+  auto bytes = static_cast<const char*>(data);
+  while (size > 0)
+  {
+#ifdef _WIN32
+    const auto written = ::_write(fd, bytes, static_cast<unsigned>(size));
+#else
+    const auto written = ::write(fd, bytes, size);
+#endif
+    if (written <= 0)
+    {
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+} // namespace
+
+QVggFrameExporter::QVggFrameExporter(Sink sink, int ringSize, Backpressure backpressure)
+  : m_sink{ std::move(sink) }
+  , m_backpressure{ backpressure }
+  , m_reads(std::max(ringSize, 1))
+  , m_buffers(std::max(ringSize, 1))
+{
+  for (auto& buffer : m_buffers)
+  {
+    m_free.push_back(&buffer);
+  }
+  m_clock.start();
+  m_writer = std::thread([this]() { write(); });
+}
+
+QVggFrameExporter::~QVggFrameExporter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_quit = true;
+  }
+  m_changed.notify_all();
+  m_writer.join();
+}
+
+QVggFrameExporter::Sink QVggFrameExporter::fileDescriptorSink(int fd, bool timestamps)
+{
+  return [fd, timestamps](const QVggFrame& frame)
+  {
+    if (timestamps)
+    {
+      const auto   us = static_cast<std::int64_t>(frame.timestampMs * 1000);
+      std::uint8_t header[8];
+      for (int i = 0; i < 8; ++i)
+      {
+        header[i] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(us) >> (8 * i));
+      }
+      if (!writeAll(fd, header, sizeof(header)))
+      {
+        return false;
+      }
+    }
+
+    const auto rowBytes = static_cast<std::size_t>(frame.width) * 4;
+    if (frame.stride == static_cast<int>(rowBytes))
+    {
+      return writeAll(fd, frame.data, rowBytes * frame.height);
+    }
+    for (int y = 0; y < frame.height; ++y)
+    {
+      if (!writeAll(fd, frame.data + y * frame.stride, rowBytes))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+}
+
+void QVggFrameExporter::capture(
+  QOpenGLContext* context,
+  unsigned        fbo,
+  const QSize&    size,
+  double          timestampMs,
+  bool            bottomUp)
+{
+  if (isStopped() || size.isEmpty())
+  {
+    return;
+  }
+
+  if (!hasPixelBuffers(context))
+  {
+    readSynchronously(context, fbo, size, timestampMs, bottomUp);
+    return;
+  }
+
+  auto  gl = context->extraFunctions();
+  auto& read = m_reads[m_nextRead];
+  m_nextRead = (m_nextRead + 1) % m_reads.size();
+
+  // The oldest read is reused, its frame is collected first.
+  if (read.inFlight)
+  {
+    collect(context, read);
+  }
+
+  const auto bytes = size.width() * size.height() * 4;
+  if (!read.pbo)
+  {
+    gl->glGenBuffers(1, &read.pbo);
+  }
+  gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pbo);
+  if (read.size != size)
+  {
+    gl->glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    read.size = size;
+  }
+
+  GLint previousFbo = 0;
+  gl->glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFbo);
+  gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+  GLint previousAlignment = 4;
+  gl->glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+  gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  gl->glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+  gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFbo);
+  gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  read.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  read.timestampMs = timestampMs;
+  read.bottomUp = bottomUp;
+  read.index = m_nextIndex++;
+  read.inFlight = true;
+}
+
+double QVggFrameExporter::elapsed() const
+{
+  return m_clock.nsecsElapsed() / 1e6;
+}
+
+void QVggFrameExporter::finish(QOpenGLContext* context)
+{
+  if (hasPixelBuffers(context))
+  {
+    auto gl = context->extraFunctions();
+    // oldest first
+    for (std::size_t i = 0; i < m_reads.size(); ++i)
+    {
+      auto& read = m_reads[(m_nextRead + i) % m_reads.size()];
+      if (read.inFlight)
+      {
+        collect(context, read);
+      }
+      if (read.pbo)
+      {
+        gl->glDeleteBuffers(1, &read.pbo);
+      }
+      read = PendingRead();
+    }
+  }
+  m_nextRead = 0;
+
+  // Wait until the writer has handed every queued frame to the sink.
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_changed.wait(lock, [this]() { return (m_queued.empty() && !m_writing) || m_stopped; });
+}
+
+bool QVggFrameExporter::isStopped() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_stopped;
+}
+
+std::uint64_t QVggFrameExporter::dropped() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_dropped;
+}
+
+void QVggFrameExporter::readSynchronously(
+  QOpenGLContext* context,
+  unsigned        fbo,
+  const QSize&    size,
+  double          timestampMs,
+  bool            bottomUp)
+{
+  auto buffer = acquireBuffer();
+  if (!buffer)
+  {
+    ++m_nextIndex;
+    return;
+  }
+
+  const auto stride = size.width() * 4;
+  std::vector<std::uint8_t> pixels(stride * size.height());
+
+  auto  gl = context->functions();
+  GLint previousFbo = 0;
+  gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+  gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  GLint previousAlignment = 4;
+  gl->glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+  gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  gl->glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+  gl->glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+
+  buffer->pixels.resize(pixels.size());
+  for (int y = 0; y < size.height(); ++y)
+  {
+    const auto row = bottomUp ? size.height() - 1 - y : y;
+    std::memcpy(buffer->pixels.data() + y * stride, pixels.data() + row * stride, stride);
+  }
+  buffer->frame =
+    QVggFrame{ buffer->pixels.data(), size.width(), size.height(), stride, timestampMs,
+               m_nextIndex++ };
+  queueBuffer(buffer);
+}
+
+void QVggFrameExporter::collect(QOpenGLContext* context, PendingRead& read)
+{
+  auto gl = context->extraFunctions();
+  auto fence = static_cast<GLsync>(read.fence);
+  gl->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  gl->glDeleteSync(fence);
+  read.fence = nullptr;
+  read.inFlight = false;
+
+  auto buffer = acquireBuffer();
+  if (!buffer)
+  {
+    return;
+  }
+
+  const auto stride = read.size.width() * 4;
+  const auto bytes = stride * read.size.height();
+
+  gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pbo);
+  auto mapped = static_cast<const std::uint8_t*>(
+    gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+  if (mapped)
+  {
+    buffer->pixels.resize(bytes);
+    for (int y = 0; y < read.size.height(); ++y)
+    {
+      const auto row = read.bottomUp ? read.size.height() - 1 - y : y;
+      std::memcpy(buffer->pixels.data() + y * stride, mapped + row * stride, stride);
+    }
+    gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (!mapped)
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_free.push_back(buffer);
+    ++m_dropped;
+    return;
+  }
+
+  buffer->frame = QVggFrame{ buffer->pixels.data(), read.size.width(), read.size.height(),
+                             stride, read.timestampMs, read.index };
+  queueBuffer(buffer);
+}
+
+QVggFrameExporter::Buffer* QVggFrameExporter::acquireBuffer()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  if (m_backpressure == Backpressure::Block)
+  {
+    m_changed.wait(lock, [this]() { return !m_free.empty() || m_stopped; });
+  }
+  if (m_free.empty() || m_stopped)
+  {
+    ++m_dropped;
+    return nullptr;
+  }
+
+  auto buffer = m_free.back();
+  m_free.pop_back();
+  return buffer;
+}
+
+void QVggFrameExporter::queueBuffer(Buffer* buffer)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_queued.push_back(buffer);
+  }
+  m_changed.notify_all();
+}
+
+// Writer thread.
+void QVggFrameExporter::write()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  for (;;)
+  {
+    m_changed.wait(lock, [this]() { return !m_queued.empty() || m_quit; });
+    if (m_queued.empty())
+    {
+      return;
+    }
+
+    auto buffer = m_queued.front();
+    m_queued.pop_front();
+    m_writing = true;
+
+    const auto stopped = m_stopped;
+    lock.unlock();
+    const auto accepted = stopped || m_sink(buffer->frame);
+    lock.lock();
+
+    m_writing = false;
+    m_stopped = m_stopped || !accepted;
+    if (m_stopped)
+    {
+      for (auto queued : m_queued)
+      {
+        m_free.push_back(queued);
+      }
+      m_queued.clear();
+    }
+    m_free.push_back(buffer);
+    m_changed.notify_all();
+  }
+}
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggImageDownsampler.hpp"
+#include "VggContainer/QVggArchive.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QSizeF>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+
+const QString K_DESIGN_FILE_NAME = QStringLiteral("design.json");
+const QString K_IMAGE_FILE_NAME_KEY = QStringLiteral("imageFileName");
+const QString K_CLASS_KEY = QStringLiteral("class");
+const QString K_IMAGE_PATTERN_PREFIX = QStringLiteral("patternImage");
+const QString K_PREPARED_MARKER_FILE_NAME = QStringLiteral(".vgg_prepared");
+
+// Skip images that would shrink by less than this factor, re-encoding them is not worth it.
+constexpr double K_MIN_DOWNSAMPLE_FACTOR = 0.8;
+
+using DisplaySizes = QHash<QString, QSizeF>;
+using ImageNames = QSet<QString>;
+
+double matrixScale(const QJsonValue& matrix)
+{
+  const auto m = matrix.toArray();
+  if (m.size() != 6)
+  {
+    return 1.0;
+  }
+
+  const auto a = m[0].toDouble(), b = m[1].toDouble(), c = m[2].toDouble(), d = m[3].toDouble();
+  return std::max(std::hypot(a, b), std::hypot(c, d));
+}
+
+// Image patterns that fit, fill or stretch the image to the element bounds. Others, e.g. tiles,
+// draw it at its own size, unknown ones are assumed to as well.
+bool scalesToBounds(const QJsonObject& object)
+{
+  const auto type = object.value(K_CLASS_KEY).toString();
+  return !type.startsWith(K_IMAGE_PATTERN_PREFIX) || type == QLatin1String("patternImageFill") ||
+         type == QLatin1String("patternImageFit") || type == QLatin1String("patternImageStretch");
+}
+
+// Images drawn at their own size are added to unscaled instead of sizes.
+void collectDisplaySizes(
+  const QJsonValue& value,
+  double            scale,
+  QSizeF            size,
+  DisplaySizes&     sizes,
+  ImageNames&       unscaled)
+{
+  if (value.isArray())
+  {
+    for (const auto& item : value.toArray())
+    {
+      collectDisplaySizes(item, scale, size, sizes, unscaled);
+    }
+    return;
+  }
+
+  if (!value.isObject())
+  {
+    return;
+  }
+
+  const auto object = value.toObject();
+
+  const auto bounds = object.value(QStringLiteral("bounds")).toObject();
+  if (!bounds.isEmpty())
+  {
+    const QSizeF boundsSize{ bounds.value(QStringLiteral("width")).toDouble(),
+                             bounds.value(QStringLiteral("height")).toDouble() };
+    scale *= matrixScale(object.value(QStringLiteral("matrix")));
+    size = boundsSize * scale;
+  }
+
+  for (auto it = object.constBegin(); it != object.constEnd(); ++it)
+  {
+    if (it.key() == K_IMAGE_FILE_NAME_KEY && it.value().isString())
+    {
+      if (!scalesToBounds(object))
+      {
+        unscaled.insert(it.value().toString());
+        continue;
+      }
+      auto& displaySize = sizes[it.value().toString()];
+      displaySize = displaySize.expandedTo(size);
+    }
+    else
+    {
+      collectDisplaySizes(it.value(), scale, size, sizes, unscaled);
+    }
+  }
+}
+
+QString documentHash(const QString& filePath, const QVggImageDownsampler::Options& options)
+{
+  QFile file{ filePath };
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return {};
+  }
+
+  QCryptographicHash hash{ QCryptographicHash::Md5 };
+  if (!hash.addData(&file))
+  {
+    return {};
+  }
+  hash.addData(QByteArray::number(options.devicePixelRatio));
+  hash.addData(QByteArray::number(options.zoomHeadroom));
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+void downsample(const QString& filePath, QSizeF targetSize)
+{
+  QImageReader reader{ filePath };
+  reader.setDecideFormatFromContent(true);
+
+  const auto sourceSize = reader.size();
+  if (!sourceSize.isValid())
+  {
+    return;
+  }
+
+  // covers the target in both directions, images drawn with a different aspect ratio are cropped
+  const auto scaledSize = QSizeF(sourceSize).scaled(targetSize, Qt::KeepAspectRatioByExpanding);
+  if (scaledSize.width() >= sourceSize.width() * K_MIN_DOWNSAMPLE_FACTOR)
+  {
+    return;
+  }
+
+  const auto format = reader.format();
+  reader.setScaledSize(
+    QSize(std::max(1, qCeil(scaledSize.width())), std::max(1, qCeil(scaledSize.height()))));
+  const auto image = reader.read();
+  if (image.isNull())
+  {
+    return;
+  }
+
+  // The runtime detects the image format from content, keep the source format and file name.
+  QImageWriter writer{ filePath, format };
+  if (!writer.canWrite())
+  {
+    return;
+  }
+  writer.write(image);
+}
+
+// The modification time of the marker records when a prepared document was last used.
+void touch(const QString& markerPath)
+{
+  QFile marker{ markerPath };
+  if (marker.open(QIODevice::ReadWrite))
+  {
+    marker.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  }
+}
+
+qint64 directorySize(const QString& path)
+{
+  qint64       size = 0;
+  QDirIterator it{ path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories };
+  while (it.hasNext())
+  {
+    it.next();
+    size += it.fileInfo().size();
+  }
+  return size;
+}
+
+// Removes the least recently used prepared documents until the cache fits the limit, except kept.
+void evict(const QDir& cacheDirectory, qint64 limit, const QString& kept)
+{
+  struct Entry
+  {
+    QString   path;
+    QDateTime lastUsed;
+    qint64    size;
+  };
+
+  std::vector<Entry> entries;
+  qint64             total = 0;
+  for (const auto& name : cacheDirectory.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+  {
+    const auto path = cacheDirectory.filePath(name);
+    // directories being prepared have no marker yet
+    const QFileInfo marker{ QDir{ path }.filePath(K_PREPARED_MARKER_FILE_NAME) };
+    if (!marker.exists())
+    {
+      continue;
+    }
+
+    const auto size = directorySize(path);
+    total += size;
+    if (name != kept)
+    {
+      entries.push_back({ path, marker.lastModified(), size });
+    }
+  }
+
+  std::sort(
+    entries.begin(),
+    entries.end(),
+    [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+  for (const auto& entry : entries)
+  {
+    if (total <= limit)
+    {
+      break;
+    }
+    if (QDir{ entry.path }.removeRecursively())
+    {
+      total -= entry.size;
+    }
+  }
+}
+
+} // namespace
+
+std::string QVggImageDownsampler::prepare(const std::string& filePath, const Options& options)
+{
+  const auto  sourcePath = QString::fromStdString(filePath);
+  QVggArchive archive{ sourcePath };
+  if (!archive.isValid() || archive.isDirectory())
+  {
+    return filePath;
+  }
+
+  const auto design = QJsonDocument::fromJson(archive.read(K_DESIGN_FILE_NAME));
+  if (!design.isObject())
+  {
+    return filePath;
+  }
+
+  DisplaySizes displaySizes;
+  ImageNames   unscaled;
+  collectDisplaySizes(design.object(), 1.0, {}, displaySizes, unscaled);
+  for (auto it = displaySizes.begin(); it != displaySizes.end();)
+  {
+    const auto keep = it.value().isEmpty() || unscaled.contains(it.key());
+    it = keep ? displaySizes.erase(it) : std::next(it);
+  }
+  if (displaySizes.isEmpty())
+  {
+    return filePath;
+  }
+
+  const auto hash = documentHash(sourcePath, options);
+  if (hash.isEmpty())
+  {
+    return filePath;
+  }
+
+  QDir cacheDirectory{ options.cacheDirectory.isEmpty()
+                         ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                             QStringLiteral("/vgg/images")
+                         : options.cacheDirectory };
+  const auto preparedPath = cacheDirectory.filePath(hash);
+  const auto markerPath = QDir{ preparedPath }.filePath(K_PREPARED_MARKER_FILE_NAME);
+  if (QFile::exists(markerPath))
+  {
+    touch(markerPath);
+    return preparedPath.toStdString();
+  }
+
+  // Prepare into a private directory first, so an interrupted run is never picked up.
+  const auto workingPath = preparedPath + QStringLiteral(".tmp");
+  QDir{ workingPath }.removeRecursively();
+  QDir{ preparedPath }.removeRecursively();
+  if (!archive.extractTo(workingPath))
+  {
+    QDir{ workingPath }.removeRecursively();
+    return filePath;
+  }
+
+  const QDir  workingDirectory{ workingPath };
+  const auto  scale = options.devicePixelRatio * options.zoomHeadroom;
+  QThreadPool pool;
+  for (auto it = displaySizes.constBegin(); it != displaySizes.constEnd(); ++it)
+  {
+    if (!archive.contains(it.key()))
+    {
+      continue;
+    }
+
+    const auto imagePath = workingDirectory.filePath(it.key());
+    const auto targetSize = it.value() * scale;
+    pool.start([imagePath, targetSize]() { downsample(imagePath, targetSize); });
+  }
+  pool.waitForDone();
+
+  QFile marker{ workingDirectory.filePath(K_PREPARED_MARKER_FILE_NAME) };
+  if (!marker.open(QIODevice::WriteOnly))
+  {
+    QDir{ workingPath }.removeRecursively();
+    return filePath;
+  }
+  marker.close();
+
+  if (!QDir{}.rename(workingPath, preparedPath))
+  {
+    QDir{ workingPath }.removeRecursively();
+    return filePath;
+  }
+
+  evict(cacheDirectory, options.cacheLimit, hash);
+  return preparedPath.toStdString();
+}
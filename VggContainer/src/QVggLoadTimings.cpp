@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggLoadTimings.hpp"
+
+#include <QLoggingCategory>
+
+#include <atomic>
+#include <chrono>
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+Q_LOGGING_CATEGORY(lcVggLoad, "vgg.load", QtWarningMsg)
+
+namespace
+{
+
+// Initialized with the other statics before main(), close enough to the process start.
+const auto s_processStart = std::chrono::steady_clock::now();
+
+std::atomic<double> s_environmentSetUpMs{ 0 };
+std::atomic<double> s_eventAdapterSetUpMs{ 0 };
+
+} // namespace
+
+QString QVggLoadTimings::toString() const
+{
+  return QStringLiteral(
+           "load timings (ms): environment %1, event adapter %2, container %3, init %4, "
+           "script check %5, image prepare %6, schema check %7, load %8 (validated %9, "
+           "preloaded %10), first paint %11, load to first frame %12, process start to first "
+           "frame %13; peak memory %14 MiB")
+    .arg(environmentSetUpMs, 0, 'f', 1)
+    .arg(eventAdapterSetUpMs, 0, 'f', 1)
+    .arg(containerCreateMs, 0, 'f', 1)
+    .arg(initMs, 0, 'f', 1)
+    .arg(scriptCheckMs, 0, 'f', 1)
+    .arg(imagePrepareMs, 0, 'f', 1)
+    .arg(schemaCheckMs, 0, 'f', 1)
+    .arg(loadMs, 0, 'f', 1)
+    .arg(QLatin1String(validated ? "yes" : "no"))
+    .arg(QLatin1String(preloaded ? "yes" : "no"))
+    .arg(firstPaintMs, 0, 'f', 1)
+    .arg(loadToFirstFrameMs, 0, 'f', 1)
+    .arg(processStartToFirstFrameMs, 0, 'f', 1)
+    .arg(peakMemoryBytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+void QVggLoadTimings::finish(double firstPaintMs, double loadToFirstFrameMs)
+{
+  environmentSetUpMs = s_environmentSetUpMs;
+  eventAdapterSetUpMs = s_eventAdapterSetUpMs;
+  this->firstPaintMs = firstPaintMs;
+  this->loadToFirstFrameMs = loadToFirstFrameMs;
+  processStartToFirstFrameMs = processUptimeMs();
+  peakMemoryBytes = processPeakMemoryBytes();
+  complete = true;
+
+  qCInfo(lcVggLoad).noquote() << toString();
+}
+
+void QVggLoadTimings::recordEnvironmentSetUp(double ms)
+{
+  s_environmentSetUpMs = ms;
+}
+
+void QVggLoadTimings::recordEventAdapterSetUp(double ms)
+{
+  s_eventAdapterSetUpMs = ms;
+}
+
+double QVggLoadTimings::processUptimeMs()
+{
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - s_processStart)
+    .count();
+}
+
+qint64 QVggLoadTimings::processPeakMemoryBytes()
+{
+#if defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return 0;
+  }
+  return static_cast<qint64>(counters.PeakWorkingSetSize);
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return 0;
+  }
+#if defined(Q_OS_MACOS)
+  return static_cast<qint64>(usage.ru_maxrss); // bytes
+#else
+  return static_cast<qint64>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggModelBinding.hpp"
+#include "VggContainer/QVggTransaction.hpp"
+
+#include <QMetaProperty>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace
+{
+
+const auto K_CHILD_OBJECTS = QStringLiteral("childObjects");
+const auto K_NAME = QStringLiteral("name");
+const auto K_ID = QStringLiteral("id");
+const auto K_MATRIX = QStringLiteral("matrix");
+
+QString elementIdOf(const QString& elementId, int row)
+{
+  return elementId.contains(QLatin1String("%1")) ? elementId.arg(row) : elementId;
+}
+
+// Names and ids of the clone and its descendants get the row appended.
+QJsonObject cloneForRow(const QJsonObject& object, int row)
+{
+  auto clone = object;
+  clone.insert(K_NAME, object.value(K_NAME).toString() + QString::number(row));
+  clone.insert(K_ID, object.value(K_ID).toString() + QLatin1Char('-') + QString::number(row));
+
+  auto children = object.value(K_CHILD_OBJECTS).toArray();
+  for (int i = 0; i < children.size(); ++i)
+  {
+    children.replace(i, cloneForRow(children.at(i).toObject(), row));
+  }
+  if (!children.isEmpty())
+  {
+    clone.insert(K_CHILD_OBJECTS, children);
+  }
+  return clone;
+}
+
+} // namespace
+
+QVggModelBinding::QVggModelBinding(std::shared_ptr<QVggDocumentAccess> access, QObject* parent)
+  : QObject(parent)
+  , m_access{ std::move(access) }
+{
+}
+
+QAbstractItemModel* QVggModelBinding::model() const
+{
+  return m_model;
+}
+
+void QVggModelBinding::setModel(QAbstractItemModel* model)
+{
+  if (model == m_model)
+  {
+    return;
+  }
+
+  for (const auto& connection : m_modelConnections)
+  {
+    QObject::disconnect(connection);
+  }
+  m_modelConnections.clear();
+
+  m_model = model;
+  connectModel();
+  resolveRoles();
+  markAll();
+  emit modelChanged();
+}
+
+void QVggModelBinding::bindRole(int role, const QString& elementId, const QString& path, int column)
+{
+  m_roleBindings.append({ role, {}, column, elementId, path });
+  markAll();
+}
+
+void QVggModelBinding::bindRole(
+  const QString& roleName,
+  const QString& elementId,
+  const QString& path,
+  int            column)
+{
+  m_roleBindings.append({ -1, roleName, column, elementId, path });
+  resolveRoles();
+  markAll();
+}
+
+void QVggModelBinding::setRowTemplate(
+  const QString& containerId,
+  const QString& templateName,
+  const QPointF& rowOffset)
+{
+  m_containerId = containerId;
+  m_templateName = templateName;
+  m_rowOffset = rowOffset;
+  m_children = {};
+  m_templateIndex = -1;
+  markAll();
+}
+
+bool QVggModelBinding::bindProperty(
+  QObject*       object,
+  const QString& property,
+  const QString& elementId,
+  const QString& path)
+{
+  if (!object)
+  {
+    return false;
+  }
+
+  const auto index = object->metaObject()->indexOfProperty(property.toUtf8().constData());
+  if (index < 0 || !object->metaObject()->property(index).hasNotifySignal())
+  {
+    return false;
+  }
+
+  const auto slot = metaObject()->method(metaObject()->indexOfSlot("onPropertyChanged()"));
+  QObject::connect(object, object->metaObject()->property(index).notifySignal(), this, slot);
+
+  m_dirtyProperties.insert(m_propertyBindings.size());
+  m_propertyBindings.append({ object, index, elementId, path });
+  schedule();
+  return true;
+}
+
+void QVggModelBinding::clear()
+{
+  setModel(nullptr);
+  for (const auto& binding : m_propertyBindings)
+  {
+    if (binding.object)
+    {
+      QObject::disconnect(binding.object, nullptr, this, nullptr);
+    }
+  }
+
+  m_roleBindings.clear();
+  m_propertyBindings.clear();
+  m_containerId.clear();
+  m_templateName.clear();
+  m_children = {};
+  m_templateIndex = -1;
+  m_elements.clear();
+  m_dirtyCells.clear();
+  m_dirtyProperties.clear();
+  m_dirtyFromRow = -1;
+  m_rowCount = 0;
+  m_dirtyAll = false;
+}
+
+void QVggModelBinding::refresh()
+{
+  m_children = {};
+  m_templateIndex = -1;
+  markAll();
+}
+
+void QVggModelBinding::flush()
+{
+  m_scheduled = false;
+
+  QVggTransaction transaction(m_access);
+
+  // The template is applied first in the transaction, before the cells of its rows.
+  const auto rows = m_model ? m_model->rowCount() : 0;
+  if (m_dirtyAll)
+  {
+    m_elements.clear();
+    m_dirtyFromRow = 0;
+    for (int i = 0; i < m_propertyBindings.size(); ++i)
+    {
+      m_dirtyProperties.insert(i);
+    }
+    m_dirtyAll = false;
+  }
+  if (m_dirtyFromRow >= 0)
+  {
+    updateRowTemplate();
+
+    // elements of the rows show other rows or are gone
+    for (int row = m_dirtyFromRow; row < std::max(rows, m_rowCount); ++row)
+    {
+      for (int i = 0; i < m_roleBindings.size(); ++i)
+      {
+        m_elements.remove(elementIdOf(m_roleBindings[i].elementId, row));
+        if (row < rows)
+        {
+          m_dirtyCells.insert({ row, i });
+        }
+      }
+    }
+    m_dirtyFromRow = -1;
+  }
+  m_rowCount = rows;
+
+  auto apply = [this](const QString& id, const QString& path, const QVariant& data)
+  {
+    auto&      target = element(id);
+    const auto value = QJsonValue::fromVariant(data);
+    if (target.value(path) != value)
+    {
+      target.setValue(path, value);
+    }
+  };
+
+  for (const auto& cell : m_dirtyCells)
+  {
+    const auto  row = cell.first;
+    const auto& binding = m_roleBindings[cell.second];
+    if (row >= rows || binding.role < 0)
+    {
+      continue;
+    }
+    apply(
+      elementIdOf(binding.elementId, row),
+      binding.path,
+      m_model->data(m_model->index(row, binding.column), binding.role));
+  }
+  m_dirtyCells.clear();
+
+  for (const auto i : m_dirtyProperties)
+  {
+    const auto& binding = m_propertyBindings[i];
+    if (binding.object)
+    {
+      const auto property = binding.object->metaObject()->property(binding.propertyIndex);
+      apply(binding.elementId, binding.path, property.read(binding.object));
+    }
+  }
+  m_dirtyProperties.clear();
+}
+
+void QVggModelBinding::onPropertyChanged()
+{
+  const auto signal = senderSignalIndex();
+  for (int i = 0; i < m_propertyBindings.size(); ++i)
+  {
+    const auto& binding = m_propertyBindings[i];
+    if (
+      binding.object == sender() &&
+      binding.object->metaObject()->property(binding.propertyIndex).notifySignalIndex() == signal)
+    {
+      m_dirtyProperties.insert(i);
+    }
+  }
+  schedule();
+}
+
+void QVggModelBinding::connectModel()
+{
+  if (!m_model)
+  {
+    return;
+  }
+
+  m_modelConnections.append(QObject::connect(
+    m_model,
+    &QAbstractItemModel::dataChanged,
+    this,
+    [this](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+    { markCells(topLeft, bottomRight, roles); }));
+
+  // rows shifting changes which element shows which row, rows before the first change keep theirs
+  auto markRows = [this](const QModelIndex& parent, int first)
+  {
+    if (!parent.isValid())
+    {
+      this->markRows(first);
+    }
+  };
+  m_modelConnections.append(QObject::connect(
+    m_model,
+    &QAbstractItemModel::rowsInserted,
+    this,
+    [markRows](const QModelIndex& parent, int first, int) { markRows(parent, first); }));
+  m_modelConnections.append(QObject::connect(
+    m_model,
+    &QAbstractItemModel::rowsRemoved,
+    this,
+    [markRows](const QModelIndex& parent, int first, int) { markRows(parent, first); }));
+  m_modelConnections.append(QObject::connect(
+    m_model,
+    &QAbstractItemModel::rowsMoved,
+    this,
+    [markRows](const QModelIndex& parent, int start, int, const QModelIndex&, int row)
+    { markRows(parent, std::min(start, row)); }));
+  m_modelConnections.append(
+    QObject::connect(m_model, &QAbstractItemModel::layoutChanged, this, [this]() { markAll(); }));
+  m_modelConnections.append(QObject::connect(
+    m_model,
+    &QAbstractItemModel::modelReset,
+    this,
+    [this]()
+    {
+      resolveRoles();
+      this->markAll();
+    }));
+}
+
+void QVggModelBinding::resolveRoles()
+{
+  if (!m_model)
+  {
+    return;
+  }
+
+  const auto roleNames = m_model->roleNames();
+  for (auto& binding : m_roleBindings)
+  {
+    if (!binding.roleName.isEmpty())
+    {
+      binding.role = roleNames.key(binding.roleName.toUtf8(), -1);
+    }
+  }
+}
+
+void QVggModelBinding::markCells(
+  const QModelIndex&  topLeft,
+  const QModelIndex&  bottomRight,
+  const QVector<int>& roles)
+{
+  for (int i = 0; i < m_roleBindings.size(); ++i)
+  {
+    const auto& binding = m_roleBindings[i];
+    if (
+      binding.column < topLeft.column() || binding.column > bottomRight.column() ||
+      (!roles.isEmpty() && !roles.contains(binding.role)))
+    {
+      continue;
+    }
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+    {
+      m_dirtyCells.insert({ row, i });
+    }
+  }
+  schedule();
+}
+
+void QVggModelBinding::markRows(int first)
+{
+  m_dirtyFromRow = m_dirtyFromRow < 0 ? first : std::min(m_dirtyFromRow, first);
+  schedule();
+}
+
+void QVggModelBinding::markAll()
+{
+  m_dirtyAll = true;
+  schedule();
+}
+
+void QVggModelBinding::schedule()
+{
+  if (m_scheduled)
+  {
+    return;
+  }
+  m_scheduled = true;
+  QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+// The container's children are replaced with the template repeated once per row.
+void QVggModelBinding::updateRowTemplate()
+{
+  if (m_containerId.isEmpty())
+  {
+    return;
+  }
+
+  QVggElement container(m_access, m_containerId.toStdString());
+  if (m_templateIndex < 0)
+  {
+    m_children = container.value(QLatin1Char('/') + K_CHILD_OBJECTS).toArray();
+    for (int i = 0; i < m_children.size(); ++i)
+    {
+      if (m_children.at(i).toObject().value(K_NAME).toString() == m_templateName)
+      {
+        m_templateIndex = i;
+        break;
+      }
+    }
+    if (m_templateIndex < 0)
+    {
+      return;
+    }
+  }
+
+  const auto templateObject = m_children.at(m_templateIndex).toObject();
+  const auto rows = m_model ? m_model->rowCount() : 0;
+
+  QJsonArray children;
+  for (int i = 0; i < m_children.size(); ++i)
+  {
+    if (i != m_templateIndex)
+    {
+      children.append(m_children.at(i));
+      continue;
+    }
+
+    for (int row = 0; row < rows; ++row)
+    {
+      auto clone = cloneForRow(templateObject, row);
+      auto matrix = clone.value(K_MATRIX).toArray();
+      if (matrix.size() == 6)
+      {
+        matrix.replace(4, matrix.at(4).toDouble() + m_rowOffset.x() * row);
+        matrix.replace(5, matrix.at(5).toDouble() + m_rowOffset.y() * row);
+        clone.insert(K_MATRIX, matrix);
+      }
+      children.append(clone);
+    }
+  }
+
+  container.setValue(QLatin1Char('/') + K_CHILD_OBJECTS, children);
+}
+
+QVggElement& QVggModelBinding::element(const QString& id)
+{
+  auto it = m_elements.find(id);
+  if (it == m_elements.end())
+  {
+    it = m_elements.insert(id, QVggElement(m_access, id.toStdString()));
+  }
+  return *it;
+}
@@ -15,16 +15,38 @@
  */
 
 #include "VggContainer/QVggOpenGLWidget.hpp"
+#include "VggContainer/QVggContainerPool.hpp"
+#include "VggContainer/QVggDispatchQueue.hpp"
+#include "VggContainer/QVggDispatcher.hpp"
+#include "VggContainer/QVggDocumentAccess.hpp"
+#include "VggContainer/QVggDocumentWatcher.hpp"
+#include "VggContainer/QVggEnvironment.hpp"
 #include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggEventQueue.hpp"
+#include "VggContainer/QVggEventRouter.hpp"
+#include "VggContainer/QVggFrameExporter.hpp"
+#include "VggContainer/QVggSchemaCache.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+#include "VggContainer/QVggSnapshot.hpp"
+#include "VggContainer/QVggTouchBatch.hpp"
+#include "VggContainer/QVggVirtualClock.hpp"
 
 #include "VGG/QtContainer.hpp"
 
+#include <QElapsedTimer>
 #include <QMouseEvent>
+#include <QNativeGestureEvent>
 #include <QOpenGLFunctions>
 #include <QTimer>
+#include <QTouchEvent>
 #include <QWheelEvent>
 #include <QWindow>
 
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
 // ======================================================================
 // QVggOpenGLWidgetImpl
 // ======================================================================
@@ -37,21 +59,86 @@ class QVggOpenGLWidgetImpl
 
   QOpenGLFunctions m_funcs;
 
+  // Guards m_container when dispatch runs on its own thread.
+  std::recursive_mutex            m_containerLock;
+  std::unique_ptr<QVggDispatcher> m_dispatcher;
+  QVggDispatchQueue               m_dispatchQueue;
+  QVggEventQueue                  m_eventQueue;
+  std::atomic_bool                m_deliveryScheduled{ false };
+  QVggKeyboardState               m_keyboardState;
+  QVggTouchBatch                  m_touchBatch;
+  std::vector<UEvent>             m_touchEvents;
+
   QTimer  m_animator;
   QPointF m_lastMouseMovePosition;
 
+  // Replaces the animator while the application drives time.
+  std::unique_ptr<QVggVirtualClock> m_virtualClock;
+
+  std::shared_ptr<QVggFrameExporter> m_frameExporter;
+
+  struct SnapshotRequest
+  {
+    QRect                rect;
+    double               scale;
+    std::promise<QImage> promise;
+  };
+  std::vector<SnapshotRequest> m_snapshots;
+  bool                         m_hasFrame{ false };
+
+  QVggLoadTimings                 m_loadTimings;
+  QElapsedTimer                   m_loadClock;
+  double                          m_containerCreateMs{ 0 };
+  double                          m_initMs{ 0 };
+  bool                            m_awaitingFirstFrame{ false };
+  bool                            m_initialized{ false };
+  bool                            m_loaded{ false };
+
+  std::shared_ptr<QVggEventRouter> m_eventRouter{ std::make_shared<QVggEventRouter>() };
+  int                              m_listenerSubscription{ 0 };
+
+  bool   m_imageDownsamplingEnabled{ false };
+  double m_zoomHeadroom{ 2.0 };
+
+  std::unique_ptr<QVggDocumentWatcher> m_watcher;
+  std::string                          m_filePath;
+  std::string                          m_designDocSchemaFilePath;
+  std::string                          m_layoutDocSchemaFilePath;
+
+  std::shared_ptr<QVggDocumentAccess> m_documentAccess;
+  QVggModelBinding*                   m_modelBinding{ nullptr };
+
 public:
   QVggOpenGLWidgetImpl(QVggOpenGLWidget* api)
     : m_api{ api }
-    , m_container{ new VGG::QtContainer }
   {
+    QElapsedTimer timer;
+    timer.start();
+    m_container = QVggContainerPool::instance().take();
+    m_containerCreateMs = timer.nsecsElapsed() / 1e6;
+
     m_animator.setInterval(16);
+
+    m_documentAccess = std::make_shared<QVggDocumentAccess>(
+      [this](const std::function<void(VGG::ISdk& sdk)>& function)
+      {
+        std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+        function(*m_container->sdk());
+      });
+  }
+
+  ~QVggOpenGLWidgetImpl()
+  {
+    setFrameExporter(nullptr);
+    m_dispatcher.reset();
+    m_documentAccess->detach();
   }
 
   // === GL ============================================================
   void initializeGL()
   {
     m_funcs.initializeOpenGLFunctions();
+    QVggShaderCache::validate(m_api->context());
   }
 
   void resizeGL(int w, int h)
@@ -66,19 +153,169 @@ public:
     evt.window.drawableWidth = w * scale;
     evt.window.drawableHeight = h * scale;
 
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
     m_container->onEvent(evt);
   }
 
   void paintGL()
   {
-    m_container->paint(true);
+    // While a script runs on the dispatch thread, the previous frame stays.
+    std::unique_lock<std::recursive_mutex> lock(m_containerLock, std::try_to_lock);
+    if (!lock)
+    {
+      return;
+    }
+
+    if (!m_awaitingFirstFrame)
+    {
+      m_container->paint(true);
+    }
+    else
+    {
+      QElapsedTimer timer;
+      timer.start();
+      m_container->paint(true);
+      m_awaitingFirstFrame = false;
+      m_loadTimings.finish(timer.nsecsElapsed() / 1e6, m_loadClock.nsecsElapsed() / 1e6);
+    }
+
+    m_hasFrame = true;
+    if (!m_snapshots.empty())
+    {
+      QMetaObject::invokeMethod(m_api, [this]() { takeSnapshots(); }, Qt::QueuedConnection);
+    }
+
+    if (m_frameExporter)
+    {
+      const auto timestamp =
+        m_virtualClock ? m_virtualClock->elapsed() : m_frameExporter->elapsed();
+      m_frameExporter->capture(
+        m_api->context(),
+        m_api->defaultFramebufferObject(),
+        m_api->size() * m_api->devicePixelRatioF(),
+        timestamp);
+    }
+  }
+
+  std::future<QImage> snapshot(const QRect& rect, double scale)
+  {
+    m_snapshots.push_back(SnapshotRequest{ rect, scale, {} });
+    auto future = m_snapshots.back().promise.get_future();
+    if (m_snapshots.size() == 1)
+    {
+      QMetaObject::invokeMethod(m_api, [this]() { takeSnapshots(); }, Qt::QueuedConnection);
+    }
+    return future;
+  }
+
+  // Reads the snapshots from the latest frame, which is still in the framebuffer of the widget.
+  void takeSnapshots()
+  {
+    if (m_snapshots.empty())
+    {
+      return;
+    }
+    if (!m_hasFrame || !m_api->context())
+    {
+      m_api->update(); // taken after the first paint
+      return;
+    }
+
+    const auto ratio = m_api->devicePixelRatioF();
+    auto       requests = std::move(m_snapshots);
+    m_snapshots.clear();
+
+    m_api->makeCurrent();
+    for (auto& request : requests)
+    {
+      const auto rect = QRectF(
+                          request.rect.x() * ratio,
+                          request.rect.y() * ratio,
+                          request.rect.width() * ratio,
+                          request.rect.height() * ratio)
+                          .toAlignedRect();
+      auto image = QVggSnapshot::grab(
+        m_api->context(),
+        nullptr,
+        m_api->size() * ratio,
+        rect,
+        request.scale);
+      request.promise.set_value(image);
+      emit m_api->snapshotReady(image);
+    }
+    m_api->doneCurrent();
+  }
+
+  void setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter)
+  {
+    if (m_frameExporter && m_api->context())
+    {
+      m_api->makeCurrent();
+      m_frameExporter->finish(m_api->context());
+      m_api->doneCurrent();
+    }
+    m_frameExporter = std::move(exporter);
   }
 
   // =================================================================
   void init(int w, int h)
   {
     m_funcs.glViewport(0, 0, w, h);
+
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+
+    QElapsedTimer timer;
+    timer.start();
     m_container->init(w, h, m_api->windowHandle()->devicePixelRatio());
+    if (!m_initialized)
+    {
+      m_initMs = timer.nsecsElapsed() / 1e6;
+      m_loadTimings.initMs = m_initMs;
+    }
+    m_initialized = true;
+  }
+
+  // Replaces the container with one loaded ahead of time by QVggContainerPool with the same
+  // schemas. The pool loads documents as they are, so downsampled documents are never adopted.
+  bool adoptPreloaded(
+    const std::string& filePath,
+    const char*        designDocSchemaFilePath,
+    const char*        layoutDocSchemaFilePath)
+  {
+    if (m_imageDownsamplingEnabled)
+    {
+      return false;
+    }
+
+    auto container = QVggContainerPool::instance().take(
+      filePath,
+      designDocSchemaFilePath,
+      layoutDocSchemaFilePath);
+    if (!container)
+    {
+      return false;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+
+    m_containerCreateMs = 0;
+    if (!m_initialized)
+    {
+      m_container = std::move(container);
+      applyEventListener();
+      return true;
+    }
+
+    // The replaced container releases its GPU resources, so the context must be current.
+    m_api->makeCurrent();
+    m_container = std::move(container);
+    applyEventListener();
+    m_initialized = false;
+    init(m_api->width(), m_api->height());
+    resizeGL(m_api->width(), m_api->height());
+    m_api->doneCurrent();
+    m_api->update();
+    return true;
   }
 
   // === api =========================================================
@@ -87,22 +324,328 @@ public:
     const char*        designDocSchemaFilePath = nullptr,
     const char*        layoutDocSchemaFilePath = nullptr)
   {
-    return m_container->load(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath);
+    m_loadClock.start();
+    m_awaitingFirstFrame = true;
+    m_documentAccess->resetBatch();
+
+    // bindings are applied again once the document is loaded
+    if (m_modelBinding)
+    {
+      m_modelBinding->refresh();
+    }
+
+    m_loadTimings = {};
+    m_loadTimings.initMs = m_initMs;
+
+    QElapsedTimer timer;
+    timer.start();
+    QVggEnvironment::setUpFor(filePath);
+    m_loadTimings.scriptCheckMs = timer.nsecsElapsed() / 1e6;
+
+    m_filePath = filePath;
+    m_designDocSchemaFilePath = designDocSchemaFilePath ? designDocSchemaFilePath : "";
+    m_layoutDocSchemaFilePath = layoutDocSchemaFilePath ? layoutDocSchemaFilePath : "";
+    if (m_watcher)
+    {
+      m_watcher->watch(QString::fromStdString(filePath));
+    }
+
+    if (!m_loaded && adoptPreloaded(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath))
+    {
+      m_loadTimings.preloaded = true;
+      m_loaded = true;
+      return true;
+    }
+    m_loadTimings.containerCreateMs = m_containerCreateMs;
+
+    timer.restart();
+
+    auto loadPath = filePath;
+    if (m_imageDownsamplingEnabled)
+    {
+      QVggImageDownsampler::Options options;
+      options.devicePixelRatio = m_api->devicePixelRatioF();
+      options.zoomHeadroom = m_zoomHeadroom;
+      loadPath = QVggImageDownsampler::prepare(filePath, options);
+      m_loadTimings.imagePrepareMs = timer.nsecsElapsed() / 1e6;
+      timer.restart();
+    }
+
+    auto&      schemaCache = QVggSchemaCache::instance();
+    const auto documentKey = schemaCache.documentKey(
+      QString::fromStdString(filePath),
+      designDocSchemaFilePath,
+      layoutDocSchemaFilePath);
+    if (schemaCache.isValidated(documentKey))
+    {
+      designDocSchemaFilePath = nullptr;
+      layoutDocSchemaFilePath = nullptr;
+    }
+    m_loadTimings.validated = designDocSchemaFilePath || layoutDocSchemaFilePath;
+    m_loadTimings.schemaCheckMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::unique_lock<std::recursive_mutex> lock(m_containerLock);
+    auto result = m_container->load(loadPath, designDocSchemaFilePath, layoutDocSchemaFilePath);
+    lock.unlock();
+    m_loadTimings.loadMs = timer.nsecsElapsed() / 1e6;
+
+    if (result && m_loadTimings.validated)
+    {
+      schemaCache.setValidated(documentKey);
+    }
+    m_loaded = true;
+    return result;
+  }
+
+  void setWatchEnabled(bool enabled)
+  {
+    if (!enabled)
+    {
+      m_watcher.reset();
+      return;
+    }
+    if (m_watcher)
+    {
+      return;
+    }
+
+    m_watcher.reset(new QVggDocumentWatcher(
+      [this](const QVggDocumentWatcher::Change& change) { applyDocumentChange(change); }));
+    if (!m_filePath.empty())
+    {
+      m_watcher->watch(QString::fromStdString(m_filePath));
+    }
+  }
+
+  void applyDocumentChange(const QVggDocumentWatcher::Change& change)
+  {
+    if (change.needsReload)
+    {
+      const auto designSchema = m_designDocSchemaFilePath;
+      const auto layoutSchema = m_layoutDocSchemaFilePath;
+      load(
+        std::string(m_filePath),
+        designSchema.empty() ? nullptr : designSchema.c_str(),
+        layoutSchema.empty() ? nullptr : layoutSchema.c_str());
+    }
+    else
+    {
+      QVggTransaction transaction(m_documentAccess);
+      for (const auto& [id, patch] : change.elementPatches)
+      {
+        m_documentAccess->updateElement(id, patch);
+      }
+    }
+    m_api->update();
   }
 
   void setEventListener(QVggOpenGLWidget::EventListener listener)
   {
+    if (m_listenerSubscription)
+    {
+      m_eventRouter->unsubscribe(m_listenerSubscription);
+      m_listenerSubscription = 0;
+    }
     if (listener)
     {
-      auto sdk = m_container->sdk();
+      m_listenerSubscription = m_eventRouter->subscribe(
+        {},
+        {},
+        [this, listener](const QVggEvent& event)
+        {
+          // routed on the GUI thread with the dispatch thread, which may be dispatching meanwhile
+          std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+          listener(m_container->sdk(), event.type, event.targetId, event.targetPath);
+        });
+    }
+    applyEventListener();
+  }
+
+  // Events reach the router only while it has subscriptions. With the dispatch thread, they are
+  // queued and routed on the GUI thread.
+  void applyEventListener()
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    if (m_eventRouter->isEmpty())
+    {
+      m_container->setEventListener(nullptr);
+    }
+    else if (m_dispatcher)
+    {
       m_container->setEventListener(
-        [listener, sdk](std::string type, std::string targetId, std::string targetPath)
-        { listener(sdk, type, targetId, targetPath); });
+        [this](std::string type, std::string targetId, std::string targetPath)
+        {
+          m_eventQueue.push({ std::move(type), std::move(targetId), std::move(targetPath) });
+          if (!m_deliveryScheduled.exchange(true))
+          {
+            QMetaObject::invokeMethod(m_api, [this]() { deliverEvents(); }, Qt::QueuedConnection);
+          }
+        });
     }
     else
     {
-      m_container->setEventListener(nullptr);
+      m_container->setEventListener(
+        [router = m_eventRouter](std::string type, std::string targetId, std::string targetPath)
+        { router->route(type, targetId, targetPath); });
+    }
+  }
+
+  void deliverEvents()
+  {
+    m_deliveryScheduled = false;
+
+    const auto done = m_dispatchQueue.deliver(
+      m_eventQueue,
+      [this](QVggEventQueue::Event& event)
+      { m_eventRouter->route(event.type, event.targetId, event.targetPath); });
+    if (!done && !m_deliveryScheduled.exchange(true))
+    {
+      // the rest after the pending paint
+      QMetaObject::invokeMethod(m_api, [this]() { deliverEvents(); }, Qt::QueuedConnection);
+    }
+  }
+
+  void setDispatchThreadEnabled(bool enabled)
+  {
+    if (enabled == (m_dispatcher != nullptr) || (enabled && m_virtualClock))
+    {
+      return;
+    }
+
+    if (enabled)
+    {
+      // the frame is kept when painting is skipped while a script runs
+      m_api->setUpdateBehavior(QOpenGLWidget::PartialUpdate);
+      m_dispatcher.reset(new QVggDispatcher([this]() { dispatch(); }));
+    }
+    else
+    {
+      m_dispatcher.reset();
+      dispatch();
+    }
+    applyEventListener();
+  }
+
+  void setVirtualClockEnabled(bool enabled)
+  {
+    if (enabled == (m_virtualClock != nullptr))
+    {
+      return;
+    }
+
+    if (enabled)
+    {
+      m_animator.stop();
+      setDispatchThreadEnabled(false);
+      m_virtualClock = std::make_unique<QVggVirtualClock>(m_animator.interval());
+    }
+    else
+    {
+      m_virtualClock.reset();
+      m_animator.start();
+    }
+    m_dispatchQueue.setBudgetSuspended(enabled);
+  }
+
+  void advance(double ms)
+  {
+    if (!m_virtualClock)
+    {
+      return;
+    }
+
+    for (auto ticks = m_virtualClock->advance(ms); ticks > 0; --ticks)
+    {
+      dispatch();
+    }
+    if (m_container->needsPaint())
+    {
+      m_api->update();
+    }
+  }
+
+  // Called by the animator on the GUI thread.
+  void tick()
+  {
+    if (m_dispatcher)
+    {
+      std::unique_lock<std::recursive_mutex> lock(m_containerLock, std::try_to_lock);
+      if (lock && m_container->needsPaint())
+      {
+        m_api->update();
+      }
+      return;
     }
+
+    if (m_container->needsPaint())
+    {
+      m_api->update();
+    }
+    dispatch();
+  }
+
+  void dispatch()
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+    applyTouchEvents();
+    m_dispatchQueue.run(
+      [this](UEvent& evt) { applyEvent(evt); },
+      [this]() { m_container->dispatch(); }); // todo, improve dispatch
+  }
+
+  // Called with the container lock held or on the GUI thread without the dispatch thread.
+  void applyEvent(UEvent& evt)
+  {
+    m_keyboardState.apply(evt);
+    QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+    m_container->onEvent(evt);
+  }
+
+  // Touch input of the frame, batched so fast multi-finger input costs one pass per tick.
+  void applyTouchEvents()
+  {
+    m_touchEvents.clear();
+    m_touchBatch.take(m_touchEvents);
+    for (auto& evt : m_touchEvents)
+    {
+      applyEvent(evt);
+    }
+  }
+
+  // With the dispatch thread, input is handed over to it, so the GUI thread never waits for
+  // a running script. With a budget, input is applied by the next ticks.
+  void sendEvent(UEvent evt)
+  {
+    if (m_dispatcher)
+    {
+      m_dispatchQueue.post(evt);
+      m_dispatcher->wake();
+      return;
+    }
+    // queued behind earlier input, otherwise applied right away even with a budget
+    if (m_virtualClock || !m_dispatchQueue.isEmpty())
+    {
+      m_dispatchQueue.post(evt);
+      return;
+    }
+
+    applyEvent(evt);
+  }
+
+  // Queued input goes first, before input is applied directly under the new budget.
+  void setDispatchBudget(double budgetMs)
+  {
+    m_dispatchQueue.setBudget(budgetMs);
+    if (m_dispatcher || m_virtualClock)
+    {
+      return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    QVggKeyboardState::Scope              keyboardScope(m_keyboardState);
+    m_dispatchQueue.drain([this](UEvent& evt) { applyEvent(evt); });
   }
 
   // === events =====================================================
@@ -112,7 +655,7 @@ public:
     evt.button.type = VGG_MOUSEBUTTONDOWN;
     fillVggEvent(evt, event);
 
-    m_container->onEvent(evt);
+    sendEvent(evt);
   }
 
   void mouseMoveEvent(QMouseEvent* event)
@@ -126,7 +669,7 @@ public:
     evt.motion.xrel = delta.x();
     evt.motion.yrel = delta.y();
 
-    m_container->onEvent(evt);
+    sendEvent(evt);
 
     m_lastMouseMovePosition = event->position();
   }
@@ -137,7 +680,7 @@ public:
     evt.button.type = VGG_MOUSEBUTTONUP;
     fillVggEvent(evt, event);
 
-    m_container->onEvent(evt);
+    sendEvent(evt);
   }
 
   void wheelEvent(QWheelEvent* event)
@@ -155,19 +698,29 @@ public:
     evt.wheel.preciseX = delta.x();
     evt.wheel.preciseY = delta.y();
 
-    m_container->onEvent(evt);
+    sendEvent(evt);
+  }
+
+  bool touchEvent(QTouchEvent* event)
+  {
+    return m_touchBatch.add(event, m_api->size());
+  }
+
+  bool nativeGestureEvent(QNativeGestureEvent* event)
+  {
+    return m_touchBatch.add(event, m_api->size());
   }
 
   void keyPressEvent(QKeyEvent* event)
   {
     auto vggEvent = QVggEventAdapter::keyPressEvent(event);
-    m_container->onEvent(vggEvent);
+    sendEvent(vggEvent);
   }
 
   void keyReleaseEvent(QKeyEvent* event)
   {
     auto vggEvent = QVggEventAdapter::keyReleaseEvent(event);
-    m_container->onEvent(vggEvent);
+    sendEvent(vggEvent);
   }
 
   // === Private ===========================================================
@@ -208,17 +761,11 @@ QVggOpenGLWidget::QVggOpenGLWidget(QWidget* parent)
     &m_impl->m_animator,
     &QTimer::timeout,
     this,
-    [this]()
-    {
-      if (this->m_impl->m_container->needsPaint())
-      {
-        this->update();
-      }
-      this->m_impl->m_container->dispatch(); // todo, improve dispatch
-    });
+    [this]() { this->m_impl->tick(); });
   m_impl->m_animator.start();
 
   setMouseTracking(true);
+  setAttribute(Qt::WA_AcceptTouchEvents);
 }
 
 QVggOpenGLWidget::~QVggOpenGLWidget()
@@ -241,6 +788,92 @@ void QVggOpenGLWidget::setEventListener(EventListener listener)
   m_impl->setEventListener(listener);
 }
 
+int QVggOpenGLWidget::subscribe(
+  const std::string& type,
+  const std::string& target,
+  EventHandler       handler)
+{
+  const auto subscription = m_impl->m_eventRouter->subscribe(type, target, std::move(handler));
+  m_impl->applyEventListener();
+  return subscription;
+}
+
+void QVggOpenGLWidget::unsubscribe(int subscription)
+{
+  m_impl->m_eventRouter->unsubscribe(subscription);
+  m_impl->applyEventListener();
+}
+
+QVggElement QVggOpenGLWidget::element(const std::string& id)
+{
+  return QVggElement(m_impl->m_documentAccess, id);
+}
+
+QVggTransaction QVggOpenGLWidget::transaction()
+{
+  return QVggTransaction(m_impl->m_documentAccess);
+}
+
+QVggModelBinding* QVggOpenGLWidget::modelBinding()
+{
+  if (!m_impl->m_modelBinding)
+  {
+    m_impl->m_modelBinding = new QVggModelBinding(m_impl->m_documentAccess, this);
+  }
+  return m_impl->m_modelBinding;
+}
+
+QVggLoadTimings QVggOpenGLWidget::loadTimings() const
+{
+  return m_impl->m_loadTimings;
+}
+
+void QVggOpenGLWidget::setImageDownsamplingEnabled(bool enabled, double zoomHeadroom)
+{
+  m_impl->m_imageDownsamplingEnabled = enabled;
+  m_impl->m_zoomHeadroom = zoomHeadroom;
+}
+
+void QVggOpenGLWidget::setWatchEnabled(bool enabled)
+{
+  m_impl->setWatchEnabled(enabled);
+}
+
+void QVggOpenGLWidget::setDispatchThreadEnabled(bool enabled)
+{
+  m_impl->setDispatchThreadEnabled(enabled);
+}
+
+void QVggOpenGLWidget::setDispatchBudget(double budgetMs)
+{
+  m_impl->setDispatchBudget(budgetMs);
+}
+
+void QVggOpenGLWidget::setVirtualClockEnabled(bool enabled)
+{
+  m_impl->setVirtualClockEnabled(enabled);
+}
+
+void QVggOpenGLWidget::advance(double ms)
+{
+  m_impl->advance(ms);
+}
+
+std::future<QImage> QVggOpenGLWidget::snapshot(const QRect& rect, double scale)
+{
+  return m_impl->snapshot(rect, scale);
+}
+
+void QVggOpenGLWidget::setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter)
+{
+  m_impl->setFrameExporter(std::move(exporter));
+}
+
+QVggDispatchStats QVggOpenGLWidget::dispatchStats() const
+{
+  return m_impl->m_dispatchQueue.stats(m_impl->m_eventQueue);
+}
+
 // === GL ===============================================================
 void QVggOpenGLWidget::initializeGL()
 {
@@ -268,6 +901,33 @@ void QVggOpenGLWidget::paintGL()
 }
 
 // === events ===============================================================
+bool QVggOpenGLWidget::event(QEvent* event)
+{
+  switch (event->type())
+  {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::TouchCancel:
+      if (m_impl->touchEvent(static_cast<QTouchEvent*>(event)))
+      {
+        event->accept();
+        return true;
+      }
+      break;
+    case QEvent::NativeGesture:
+      if (m_impl->nativeGestureEvent(static_cast<QNativeGestureEvent*>(event)))
+      {
+        event->accept();
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  return QOpenGLWidget::event(event);
+}
+
 void QVggOpenGLWidget::mousePressEvent(QMouseEvent* event)
 {
   m_impl->mousePressEvent(event);
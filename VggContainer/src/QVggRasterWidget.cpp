@@ -0,0 +1,670 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggRasterWidget.hpp"
+#include "VggContainer/QVggContainerPool.hpp"
+#include "VggContainer/QVggDocumentAccess.hpp"
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggRemoteContainer.hpp"
+#include "VggContainer/QVggTileCache.hpp"
+
+#include "VGG/QtContainer.hpp"
+
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QPainter>
+#include <QTimer>
+#include <QWheelEvent>
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+// Frames are composed from cached tiles until panning paused this long.
+constexpr qint64 PAN_SETTLE_MS = 150;
+
+} // namespace
+
+// ======================================================================
+// QVggRasterWidgetImpl
+// ======================================================================
+class QVggRasterWidgetImpl
+{
+  friend QVggRasterWidget;
+
+  QVggRasterWidget*                 m_api;
+  std::unique_ptr<VGG::QtContainer> m_container;
+
+  // Event handlers may access elements while the container handles an event.
+  std::recursive_mutex m_containerLock;
+
+  // Replaces m_container when rendering out of process.
+  std::unique_ptr<QVggRemoteContainer> m_remote;
+
+  std::unique_ptr<QOffscreenSurface>        m_surface;
+  std::unique_ptr<QOpenGLContext>           m_context;
+  std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+  QImage                                    m_frame;
+
+  QTimer            m_animator;
+  QPointF           m_lastMouseMovePosition;
+  QVggKeyboardState m_keyboardState;
+
+  // Present with tiled rendering, offset is where the canvas moved by panning, in device pixels.
+  std::unique_ptr<QVggTileCache> m_tileCache;
+  QPoint                         m_canvasOffset;
+  QPoint                         m_presentedOffset;
+  QPoint                         m_renderedOffset;
+  bool                           m_panConfirmed{ false };
+  QElapsedTimer                  m_panClock;
+  bool                           m_contentMayChange{ false };
+
+  QVggLoadTimings m_loadTimings;
+  QElapsedTimer   m_loadClock;
+  bool            m_awaitingFirstFrame{ false };
+  bool            m_initialized{ false };
+
+  std::shared_ptr<QVggEventRouter>    m_eventRouter{ std::make_shared<QVggEventRouter>() };
+  int                                 m_listenerSubscription{ 0 };
+  std::shared_ptr<QVggDocumentAccess> m_documentAccess;
+
+public:
+  QVggRasterWidgetImpl(QVggRasterWidget* api)
+    : m_api{ api }
+  {
+    QElapsedTimer timer;
+    timer.start();
+    m_container = QVggContainerPool::instance().take();
+    m_loadTimings.containerCreateMs = timer.nsecsElapsed() / 1e6;
+
+    m_animator.setInterval(16);
+
+    m_documentAccess = makeDocumentAccess();
+  }
+
+  std::shared_ptr<QVggDocumentAccess> makeDocumentAccess()
+  {
+    if (m_remote)
+    {
+      return std::make_shared<QVggDocumentAccess>(QVggDocumentAccess::Forwarder{
+        [this](const std::string& id) { return m_remote->getElement(id); },
+        [this](const QVggDocumentAccess::Forwarder::Updates& updates)
+        { m_remote->updateElements(updates); } });
+    }
+
+    return std::make_shared<QVggDocumentAccess>(
+      [this](const std::function<void(VGG::ISdk& sdk)>& function)
+      {
+        std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+        m_contentMayChange = true;
+        function(*m_container->sdk());
+      });
+  }
+
+  ~QVggRasterWidgetImpl()
+  {
+    m_documentAccess->detach();
+
+    // the container releases its GPU resources
+    if (m_context && m_context->makeCurrent(m_surface.get()))
+    {
+      m_fbo.reset();
+      m_container.reset();
+      m_context->doneCurrent();
+    }
+  }
+
+  // === rendering ===================================================
+  bool makeCurrent()
+  {
+    if (!m_context)
+    {
+      m_context = std::make_unique<QOpenGLContext>();
+      if (!m_context->create())
+      {
+        qWarning("QVggRasterWidget: no OpenGL context, see "
+                 "QVggEnvironment::setUpSoftwareRendering()");
+        return false;
+      }
+
+      m_surface = std::make_unique<QOffscreenSurface>();
+      m_surface->setFormat(m_context->format());
+      m_surface->create();
+    }
+    return m_context->makeCurrent(m_surface.get());
+  }
+
+  // Renders the frame into the framebuffer, whose size follows the widget, and reads it back.
+  void render()
+  {
+    if (m_remote)
+    {
+      m_remote->resize(m_api->size(), m_api->devicePixelRatioF());
+      return;
+    }
+
+    const auto ratio = m_api->devicePixelRatioF();
+    const auto size = m_api->size() * ratio;
+    if (size.isEmpty() || !makeCurrent())
+    {
+      return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+
+    // The container takes the bound framebuffer as its target when it is initialized or resized.
+    if (!m_fbo || m_fbo->size() != size)
+    {
+      m_fbo = std::make_unique<QOpenGLFramebufferObject>(
+        size,
+        QOpenGLFramebufferObject::CombinedDepthStencil);
+      m_fbo->bind();
+      resize(ratio);
+      if (m_tileCache)
+      {
+        m_tileCache->clear();
+        m_panConfirmed = false;
+      }
+    }
+
+    m_fbo->bind();
+    if (!m_awaitingFirstFrame)
+    {
+      m_container->paint(true);
+    }
+    else
+    {
+      QElapsedTimer timer;
+      timer.start();
+      m_container->paint(true);
+      m_awaitingFirstFrame = false;
+      m_loadTimings.finish(timer.nsecsElapsed() / 1e6, m_loadClock.nsecsElapsed() / 1e6);
+    }
+
+    m_frame = m_fbo->toImage(true);
+    m_frame.setDevicePixelRatio(ratio);
+    m_fbo->release();
+    m_context->doneCurrent();
+
+    if (m_tileCache)
+    {
+      // The expected offset is confirmed once a panned frame equals the cached tiles it overlaps.
+      const auto moved = m_canvasOffset - m_renderedOffset;
+      const bool overlaps = m_tileCache->memoryUsage() > 0 &&
+                            std::abs(moved.x()) < m_frame.width() &&
+                            std::abs(moved.y()) < m_frame.height();
+      if (!m_tileCache->matches(m_frame, m_canvasOffset))
+      {
+        m_tileCache->clear();
+        m_panConfirmed = false;
+      }
+      else if (!moved.isNull() && overlaps)
+      {
+        m_panConfirmed = true;
+      }
+      m_tileCache->insert(m_frame, m_canvasOffset);
+      m_renderedOffset = m_canvasOffset;
+      m_presentedOffset = m_canvasOffset;
+      m_contentMayChange = false;
+    }
+
+    m_api->update();
+  }
+
+  // Returns false if the cached tiles do not cover the view while panning, which then needs
+  // rendering. Rendered frames must have confirmed that the runtime pans as expected first.
+  bool presentFromTiles()
+  {
+    const bool panning = m_tileCache && m_panConfirmed && !m_frame.isNull() &&
+                         m_panClock.isValid() && m_panClock.elapsed() < PAN_SETTLE_MS &&
+                         !m_contentMayChange;
+    const auto size = m_frame.size();
+    if (!panning || !m_tileCache->covers(size, m_canvasOffset))
+    {
+      return false;
+    }
+    if (m_presentedOffset == m_canvasOffset)
+    {
+      return true;
+    }
+
+    QImage   frame(size, m_frame.format());
+    QPainter painter(&frame);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    m_tileCache->draw(painter, size, m_canvasOffset);
+    painter.end();
+
+    frame.setDevicePixelRatio(m_frame.devicePixelRatio());
+    m_frame = frame;
+    m_presentedOffset = m_canvasOffset;
+    m_api->update();
+    return true;
+  }
+
+  // Called with the context current and the container lock held.
+  void resize(double ratio)
+  {
+    const auto w = m_api->width();
+    const auto h = m_api->height();
+    if (!m_initialized)
+    {
+      QElapsedTimer timer;
+      timer.start();
+      m_container->init(w, h, ratio);
+      m_loadTimings.initMs = timer.nsecsElapsed() / 1e6;
+      m_initialized = true;
+    }
+
+    UEvent evt;
+    evt.window.type = VGG_WINDOWEVENT;
+    evt.window.event = VGG_WINDOWEVENT_SIZE_CHANGED;
+    evt.window.data1 = w;
+    evt.window.data2 = h;
+    evt.window.drawableWidth = w * ratio;
+    evt.window.drawableHeight = h * ratio;
+    m_container->onEvent(evt);
+  }
+
+  // Called by the animator on the GUI thread.
+  void tick()
+  {
+    if (m_remote)
+    {
+      return; // the host renders on its own
+    }
+
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+      m_container->dispatch();
+    }
+    if ((m_container->needsPaint() || !m_fbo) && !presentFromTiles())
+    {
+      render();
+    }
+  }
+
+  // === api =========================================================
+  bool load(
+    const std::string& filePath,
+    const char*        designDocSchemaFilePath,
+    const char*        layoutDocSchemaFilePath)
+  {
+    m_loadClock.start();
+    m_documentAccess->resetBatch();
+    if (m_remote)
+    {
+      return m_remote->load(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath);
+    }
+
+    m_awaitingFirstFrame = true;
+    if (m_tileCache)
+    {
+      m_tileCache->clear();
+      m_panConfirmed = false;
+    }
+
+    const auto initMs = m_loadTimings.initMs;
+    const auto containerCreateMs = m_loadTimings.containerCreateMs;
+    m_loadTimings = {};
+    m_loadTimings.initMs = initMs;
+    m_loadTimings.containerCreateMs = containerCreateMs;
+
+    QElapsedTimer timer;
+    timer.start();
+    QVggEnvironment::setUpFor(filePath);
+    m_loadTimings.scriptCheckMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    auto result = m_container->load(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath);
+    m_loadTimings.loadMs = timer.nsecsElapsed() / 1e6;
+    return result;
+  }
+
+  void setEventListener(QVggRasterWidget::EventListener listener)
+  {
+    if (m_listenerSubscription)
+    {
+      m_eventRouter->unsubscribe(m_listenerSubscription);
+      m_listenerSubscription = 0;
+    }
+    if (listener)
+    {
+      m_listenerSubscription = m_eventRouter->subscribe(
+        {},
+        {},
+        [this, listener](const QVggEvent& event)
+        {
+          listener(
+            m_remote ? nullptr : m_container->sdk(),
+            event.type,
+            event.targetId,
+            event.targetPath);
+        });
+    }
+    applyEventListener();
+  }
+
+  // Events reach the router only while it has subscriptions.
+  void applyEventListener()
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    if (m_remote)
+    {
+      m_container->setEventListener(nullptr);
+      m_remote->setEventListener(nullptr);
+      if (!m_eventRouter->isEmpty())
+      {
+        m_remote->setEventListener(
+          [router = m_eventRouter](std::string type, std::string targetId, std::string targetPath)
+          { router->route(type, targetId, targetPath); });
+      }
+    }
+    else if (m_eventRouter->isEmpty())
+    {
+      m_container->setEventListener(nullptr);
+    }
+    else
+    {
+      m_container->setEventListener(
+        [router = m_eventRouter](std::string type, std::string targetId, std::string targetPath)
+        { router->route(type, targetId, targetPath); });
+    }
+  }
+
+  void setTiledRenderingEnabled(bool enabled, qint64 memoryCapBytes)
+  {
+    if (!enabled)
+    {
+      m_tileCache.reset();
+    }
+    else if (m_tileCache)
+    {
+      m_tileCache->setMemoryCap(memoryCapBytes);
+    }
+    else
+    {
+      m_tileCache = std::make_unique<QVggTileCache>(memoryCapBytes);
+    }
+  }
+
+  void setOutOfProcessEnabled(bool enabled)
+  {
+    if (enabled == (m_remote != nullptr))
+    {
+      return;
+    }
+
+    if (enabled)
+    {
+      m_remote = std::make_unique<QVggRemoteContainer>();
+      QObject::connect(
+        m_remote.get(),
+        &QVggRemoteContainer::frameReady,
+        m_api,
+        [this]()
+        {
+          m_frame = m_remote->frame();
+          m_api->update();
+        });
+    }
+    else
+    {
+      m_remote.reset();
+      m_frame = QImage();
+      if (m_fbo && makeCurrent())
+      {
+        m_fbo.reset(); // rendered again
+        m_context->doneCurrent();
+      }
+    }
+
+    m_documentAccess->detach();
+    m_documentAccess = makeDocumentAccess();
+    applyEventListener();
+    render();
+  }
+
+  // Input other than panning may change the content, e.g. hover states.
+  void sendEvent(UEvent evt, bool panning = false)
+  {
+    if (m_remote)
+    {
+      m_remote->sendEvent(evt); // the host keeps the keyboard state
+      return;
+    }
+
+    if (!panning)
+    {
+      m_contentMayChange = true;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_containerLock);
+    m_keyboardState.apply(evt);
+    QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+    m_container->onEvent(evt);
+  }
+
+  // === events =====================================================
+  void mouseButtonEvent(QMouseEvent* event, uint32_t type)
+  {
+    UEvent evt;
+    evt.button.type = type;
+    switch (event->button())
+    {
+      case Qt::LeftButton:
+        evt.button.button = 1;
+        break;
+      case Qt::MiddleButton:
+        evt.button.button = 2;
+        break;
+      case Qt::RightButton:
+        evt.button.button = 3;
+        break;
+      default:
+        break;
+    }
+    evt.button.windowX = event->position().x();
+    evt.button.windowY = event->position().y();
+
+    sendEvent(evt);
+  }
+
+  void mouseMoveEvent(QMouseEvent* event)
+  {
+    UEvent evt;
+    evt.motion.type = VGG_MOUSEMOTION;
+    evt.motion.windowX = event->position().x();
+    evt.motion.windowY = event->position().y();
+
+    auto delta = event->position() - m_lastMouseMovePosition;
+    evt.motion.xrel = delta.x();
+    evt.motion.yrel = delta.y();
+
+    sendEvent(evt);
+
+    m_lastMouseMovePosition = event->position();
+  }
+
+  void wheelEvent(QWheelEvent* event)
+  {
+    UEvent evt;
+    evt.wheel.type = VGG_MOUSEWHEEL;
+
+    auto p = event->position();
+    evt.wheel.mouseX = p.x();
+    evt.wheel.mouseY = p.y();
+
+    auto delta = event->pixelDelta();
+    evt.wheel.x = delta.x();
+    evt.wheel.y = delta.y();
+    evt.wheel.preciseX = delta.x();
+    evt.wheel.preciseY = delta.y();
+
+    // the runtime pans the canvas by the delta, or zooms with the control key. Mouse wheels only
+    // report angles, they send no delta.
+    const bool panning =
+      m_tileCache && !delta.isNull() && !(event->modifiers() & Qt::ControlModifier);
+    if (panning)
+    {
+      m_canvasOffset += (QPointF(delta) * m_api->devicePixelRatioF()).toPoint();
+      m_panClock.restart();
+    }
+    sendEvent(evt, panning);
+  }
+};
+
+// ======================================================================
+// QVggRasterWidget
+// ======================================================================
+QVggRasterWidget::QVggRasterWidget(QWidget* parent)
+  : QWidget(parent)
+  , m_impl(new QVggRasterWidgetImpl(this))
+{
+  QObject::connect(
+    &m_impl->m_animator,
+    &QTimer::timeout,
+    this,
+    [this]() { this->m_impl->tick(); });
+  m_impl->m_animator.start();
+
+  // every pixel is painted from the frame
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  setMouseTracking(true);
+  setFocusPolicy(Qt::StrongFocus);
+}
+
+QVggRasterWidget::~QVggRasterWidget()
+{
+  m_impl->m_animator.stop();
+  delete m_impl;
+}
+
+// === api ===============================================================
+bool QVggRasterWidget::load(
+  const std::string& filePath,
+  const char*        designDocSchemaFilePath,
+  const char*        layoutDocSchemaFilePath)
+{
+  return m_impl->load(filePath, designDocSchemaFilePath, layoutDocSchemaFilePath);
+}
+
+void QVggRasterWidget::setEventListener(EventListener listener)
+{
+  m_impl->setEventListener(listener);
+}
+
+int QVggRasterWidget::subscribe(
+  const std::string& type,
+  const std::string& target,
+  EventHandler       handler)
+{
+  const auto subscription = m_impl->m_eventRouter->subscribe(type, target, std::move(handler));
+  m_impl->applyEventListener();
+  return subscription;
+}
+
+void QVggRasterWidget::unsubscribe(int subscription)
+{
+  m_impl->m_eventRouter->unsubscribe(subscription);
+  m_impl->applyEventListener();
+}
+
+QVggElement QVggRasterWidget::element(const std::string& id)
+{
+  return QVggElement(m_impl->m_documentAccess, id);
+}
+
+QVggTransaction QVggRasterWidget::transaction()
+{
+  return QVggTransaction(m_impl->m_documentAccess);
+}
+
+QVggLoadTimings QVggRasterWidget::loadTimings() const
+{
+  return m_impl->m_loadTimings;
+}
+
+QImage QVggRasterWidget::frame() const
+{
+  // frames of the host are overwritten in the shared memory
+  return m_impl->m_remote ? m_impl->m_frame.copy() : m_impl->m_frame;
+}
+
+void QVggRasterWidget::setOutOfProcessEnabled(bool enabled)
+{
+  m_impl->setOutOfProcessEnabled(enabled);
+}
+
+void QVggRasterWidget::setTiledRenderingEnabled(bool enabled, qint64 memoryCapBytes)
+{
+  m_impl->setTiledRenderingEnabled(enabled, memoryCapBytes);
+}
+
+// === painting ===============================================================
+void QVggRasterWidget::paintEvent(QPaintEvent*)
+{
+  QPainter painter(this);
+  if (m_impl->m_frame.isNull())
+  {
+    painter.fillRect(rect(), palette().window());
+    return;
+  }
+  painter.drawImage(QPointF(0, 0), m_impl->m_frame);
+}
+
+void QVggRasterWidget::resizeEvent(QResizeEvent*)
+{
+  m_impl->render();
+}
+
+// === events ===============================================================
+void QVggRasterWidget::mousePressEvent(QMouseEvent* event)
+{
+  m_impl->mouseButtonEvent(event, VGG_MOUSEBUTTONDOWN);
+}
+
+void QVggRasterWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+  m_impl->mouseButtonEvent(event, VGG_MOUSEBUTTONUP);
+}
+
+void QVggRasterWidget::mouseMoveEvent(QMouseEvent* event)
+{
+  m_impl->mouseMoveEvent(event);
+}
+
+void QVggRasterWidget::wheelEvent(QWheelEvent* event)
+{
+  m_impl->wheelEvent(event);
+}
+
+void QVggRasterWidget::keyPressEvent(QKeyEvent* event)
+{
+  m_impl->sendEvent(QVggEventAdapter::keyPressEvent(event));
+}
+
+void QVggRasterWidget::keyReleaseEvent(QKeyEvent* event)
+{
+  m_impl->sendEvent(QVggEventAdapter::keyReleaseEvent(event));
+}
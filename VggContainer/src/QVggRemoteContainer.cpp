@@ -0,0 +1,517 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggRemoteContainer.hpp"
+#include "VggContainer/QVggRemoteProtocol.hpp"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QSharedMemory>
+
+#include <atomic>
+
+namespace
+{
+
+// A host is restarted when it did not answer for this long, e.g. while a script loops.
+constexpr qint64 HOST_TIMEOUT_MS = 10000;
+constexpr int    WATCHDOG_INTERVAL_MS = 1000;
+constexpr int    REPLY_TIMEOUT_MS = 1000;
+// Element reads do not wait for a host that missed this many pings.
+constexpr qint64 UNRESPONSIVE_MS = 2 * WATCHDOG_INTERVAL_MS + 500;
+// Restarts per loaded document, a document that crashes the runtime on load is not retried forever.
+constexpr int MAX_RESTARTS = 3;
+
+QString& getHostProgram()
+{
+  static QString s_hostProgram;
+  return s_hostProgram;
+}
+
+QByteArray randomHex(int bytes)
+{
+  QByteArray random(bytes, Qt::Uninitialized);
+  for (auto& byte : random)
+  {
+    byte = static_cast<char>(QRandomGenerator::system()->bounded(256));
+  }
+  return random.toHex();
+}
+
+// Names of servers and shared memory, unique per process and not predictable.
+QString uniqueName(const char* kind)
+{
+  static std::atomic_int s_counter{ 0 };
+  return QString("vgg-%1-%2-%3-%4")
+    .arg(kind)
+    .arg(QCoreApplication::applicationPid())
+    .arg(++s_counter)
+    .arg(QString::fromLatin1(randomHex(8)));
+}
+
+QByteArray toBytes(const char* text)
+{
+  return text ? QByteArray(text) : QByteArray();
+}
+
+} // namespace
+
+QVggRemoteContainer::QVggRemoteContainer(QObject* parent)
+  : QObject(parent)
+{
+  m_server.setSocketOptions(QLocalServer::UserAccessOption);
+  connect(&m_server, &QLocalServer::newConnection, this, &QVggRemoteContainer::connectHost);
+  connect(
+    &m_process,
+    QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+    this,
+    &QVggRemoteContainer::hostFinished);
+  m_process.setProcessChannelMode(QProcess::ForwardedChannels);
+
+  m_watchdog.setInterval(WATCHDOG_INTERVAL_MS);
+  connect(&m_watchdog, &QTimer::timeout, this, &QVggRemoteContainer::checkHost);
+}
+
+QVggRemoteContainer::~QVggRemoteContainer()
+{
+  m_stopping = true;
+  m_watchdog.stop();
+
+  // the host quits when the connection closes
+  if (m_socket)
+  {
+    m_socket->disconnectFromServer();
+  }
+  if (m_process.state() != QProcess::NotRunning && !m_process.waitForFinished(1000))
+  {
+    m_process.kill();
+    m_process.waitForFinished(1000);
+  }
+}
+
+void QVggRemoteContainer::setHostProgram(const QString& path)
+{
+  getHostProgram() = path;
+}
+
+QString QVggRemoteContainer::hostProgram()
+{
+  if (getHostProgram().isEmpty())
+  {
+    return QDir(QCoreApplication::applicationDirPath()).filePath("VggRenderHost");
+  }
+  return getHostProgram();
+}
+
+bool QVggRemoteContainer::load(
+  const std::string& filePath,
+  const char*        designDocSchemaFilePath,
+  const char*        layoutDocSchemaFilePath)
+{
+  m_restarts = 0;
+  m_elements.clear();
+  m_loadMessage = QVggRemoteProtocol::message(
+    QVggRemoteProtocol::Load,
+    QByteArray::fromStdString(filePath),
+    toBytes(designDocSchemaFilePath),
+    toBytes(layoutDocSchemaFilePath));
+
+  if (!startHost())
+  {
+    return false;
+  }
+  send(m_loadMessage);
+  return true;
+}
+
+void QVggRemoteContainer::resize(QSize size, double devicePixelRatio)
+{
+  if (size.isEmpty() || (size == m_size && devicePixelRatio == m_devicePixelRatio && m_memory))
+  {
+    return;
+  }
+
+  const auto pixels = (QSizeF(size) * devicePixelRatio).toSize();
+  const auto frameBytes = qint64(pixels.width()) * pixels.height() * 4;
+  auto       memory = std::make_shared<QSharedMemory>(uniqueName("frames"));
+  if (!memory->create(frameBytes * QVggRemoteProtocol::FRAME_BUFFERS))
+  {
+    qWarning().noquote() << "QVggRemoteContainer: no shared memory," << memory->errorString();
+    return;
+  }
+
+  // The current frame keeps the previous memory until it is replaced.
+  m_memory = std::move(memory);
+  m_size = size;
+  m_devicePixelRatio = devicePixelRatio;
+  m_frameBuffer = -1;
+
+  m_resizeMessage = QVggRemoteProtocol::message(
+    QVggRemoteProtocol::Resize,
+    size.width(),
+    size.height(),
+    devicePixelRatio,
+    m_memory->key(),
+    ++m_generation);
+  send(m_resizeMessage);
+}
+
+void QVggRemoteContainer::sendEvent(const UEvent& evt)
+{
+  send(QVggRemoteProtocol::message(
+    QVggRemoteProtocol::Input,
+    QByteArray(reinterpret_cast<const char*>(&evt), sizeof(evt))));
+}
+
+void QVggRemoteContainer::setEventListener(EventListener listener)
+{
+  m_listener = std::move(listener);
+}
+
+std::string QVggRemoteContainer::getElement(const std::string& id)
+{
+  auto cached = m_elements.find(id);
+  if (!m_socket || !m_responsive || m_awaitedRequest)
+  {
+    return cached != m_elements.end() ? cached->second : std::string();
+  }
+
+  const auto request = ++m_lastRequest;
+  m_awaitedRequest = request;
+  m_replied = false;
+  send(QVggRemoteProtocol::message(
+    QVggRemoteProtocol::GetElement,
+    request,
+    QByteArray::fromStdString(id)));
+
+  QElapsedTimer timer;
+  timer.start();
+  while (m_socket && !m_replied && timer.elapsed() < REPLY_TIMEOUT_MS)
+  {
+    readMessages();
+    if (!m_replied && m_socket)
+    {
+      m_socket->waitForReadyRead(static_cast<int>(REPLY_TIMEOUT_MS - timer.elapsed()));
+    }
+  }
+  m_awaitedRequest = 0;
+
+  if (!m_queuedEvents.empty() && !m_deliveryScheduled)
+  {
+    m_deliveryScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { deliverEvents(); }, Qt::QueuedConnection);
+  }
+
+  if (!m_replied)
+  {
+    m_responsive = false; // until the next pong
+    return cached != m_elements.end() ? cached->second : std::string();
+  }
+  m_elements[id] = m_reply;
+  return std::move(m_reply);
+}
+
+void QVggRemoteContainer::updateElements(
+  const std::vector<std::pair<std::string, std::string>>& updates)
+{
+  QList<QByteArray> ids;
+  QList<QByteArray> patches;
+  for (const auto& [id, patch] : updates)
+  {
+    ids.append(QByteArray::fromStdString(id));
+    patches.append(QByteArray::fromStdString(patch));
+  }
+  send(QVggRemoteProtocol::message(QVggRemoteProtocol::UpdateElements, ids, patches));
+}
+
+QImage QVggRemoteContainer::frame() const
+{
+  return m_frame;
+}
+
+bool QVggRemoteContainer::startHost()
+{
+  if (m_process.state() != QProcess::NotRunning)
+  {
+    return true;
+  }
+
+  if (!m_server.isListening() && !m_server.listen(uniqueName("render")))
+  {
+    qWarning().noquote() << "QVggRemoteContainer: cannot listen," << m_server.errorString();
+    return false;
+  }
+
+  m_token = randomHex(16);
+  m_process.start(hostProgram(), { m_server.fullServerName(), QString::fromLatin1(m_token) });
+  if (!m_process.waitForStarted())
+  {
+    qWarning().noquote() << "QVggRemoteContainer: cannot start" << hostProgram();
+    return false;
+  }
+
+  m_lastPong.start();
+  m_watchdog.start();
+  return true;
+}
+
+void QVggRemoteContainer::send(const QByteArray& message)
+{
+  if (m_socket)
+  {
+    m_socket->write(message);
+  }
+  else
+  {
+    m_pending += message;
+  }
+}
+
+void QVggRemoteContainer::connectHost()
+{
+  while (auto socket = m_server.nextPendingConnection())
+  {
+    if (m_socket)
+    {
+      socket->abort();
+      socket->deleteLater();
+      continue;
+    }
+
+    // Accepted once it sent the token of the started host.
+    connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { verifyHost(socket); });
+    connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+  }
+}
+
+void QVggRemoteContainer::verifyHost(QLocalSocket* socket)
+{
+  auto       buffer = socket->property("vggBuffer").toByteArray() + socket->readAll();
+  QByteArray payload;
+  if (!QVggRemoteProtocol::takeMessage(buffer, payload))
+  {
+    if (buffer.size() > 1024)
+    {
+      socket->abort();
+    }
+    socket->setProperty("vggBuffer", buffer);
+    return;
+  }
+
+  QDataStream stream(payload);
+  quint8      type;
+  QByteArray  token;
+  stream >> type >> token;
+  if (m_socket || type != QVggRemoteProtocol::Hello || token.isEmpty() || token != m_token)
+  {
+    qWarning("QVggRemoteContainer: rejected a connection that is not the host");
+    socket->abort();
+    return;
+  }
+
+  disconnect(socket, nullptr, this, nullptr);
+  m_socket = socket;
+  connect(m_socket, &QLocalSocket::readyRead, this, &QVggRemoteContainer::readMessages);
+  m_lastPong.restart();
+  m_responsive = true;
+
+  m_socket->write(m_pending);
+  m_pending.clear();
+
+  m_readBuffer = buffer;
+  readMessages();
+}
+
+void QVggRemoteContainer::readMessages()
+{
+  if (!m_socket)
+  {
+    return;
+  }
+
+  // Messages are taken from the buffer before they are handled, listeners may read again.
+  m_readBuffer += m_socket->readAll();
+  QByteArray payload;
+  while (QVggRemoteProtocol::takeMessage(m_readBuffer, payload))
+  {
+    handleMessage(payload);
+  }
+}
+
+void QVggRemoteContainer::handleMessage(const QByteArray& payload)
+{
+  QDataStream stream(payload);
+  quint8      type;
+  stream >> type;
+
+  switch (type)
+  {
+    case QVggRemoteProtocol::Loaded:
+    {
+      bool result;
+      stream >> result;
+      if (!result)
+      {
+        qWarning("QVggRemoteContainer: the host failed to load the document");
+      }
+      break;
+    }
+    case QVggRemoteProtocol::Frame:
+    {
+      quint32 generation;
+      int     buffer, width, height, bytesPerLine, format;
+      stream >> generation >> buffer >> width >> height >> bytesPerLine >> format;
+      presentFrame(generation, buffer, QSize(width, height), bytesPerLine, format);
+      break;
+    }
+    case QVggRemoteProtocol::Event:
+    {
+      QByteArray eventType, targetId, targetPath;
+      stream >> eventType >> targetId >> targetPath;
+      if (m_awaitedRequest || !m_queuedEvents.empty())
+      {
+        // not delivered from inside the element read, handlers may read elements, and in order
+        m_queuedEvents.push_back({ eventType, targetId, targetPath });
+      }
+      else if (m_listener)
+      {
+        m_listener(eventType.toStdString(), targetId.toStdString(), targetPath.toStdString());
+      }
+      break;
+    }
+    case QVggRemoteProtocol::Element:
+    {
+      quint32    request;
+      QByteArray element;
+      stream >> request >> element;
+      if (request == m_awaitedRequest)
+      {
+        m_reply = element.toStdString();
+        m_replied = true;
+      }
+      break;
+    }
+    case QVggRemoteProtocol::Pong:
+      m_lastPong.restart();
+      m_responsive = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void QVggRemoteContainer::deliverEvents()
+{
+  m_deliveryScheduled = false;
+  auto events = std::move(m_queuedEvents);
+  m_queuedEvents.clear();
+  for (const auto& [type, targetId, targetPath] : events)
+  {
+    if (m_listener)
+    {
+      m_listener(type.toStdString(), targetId.toStdString(), targetPath.toStdString());
+    }
+  }
+}
+
+void QVggRemoteContainer::presentFrame(
+  quint32 generation,
+  int     buffer,
+  QSize   size,
+  int     bytesPerLine,
+  int     format)
+{
+  const auto bufferBytes = m_memory ? m_memory->size() / QVggRemoteProtocol::FRAME_BUFFERS : 0;
+  if (
+    generation != m_generation || buffer < 0 || buffer >= QVggRemoteProtocol::FRAME_BUFFERS ||
+    qint64(bytesPerLine) * size.height() > bufferBytes)
+  {
+    return; // rendered before a resize, the host forgets it with the generation
+  }
+
+  // The host renders the next frame into the buffer of the current one.
+  if (m_frameBuffer >= 0)
+  {
+    send(QVggRemoteProtocol::message(
+      QVggRemoteProtocol::ReleaseFrame,
+      m_generation,
+      m_frameBuffer));
+  }
+
+  const auto data = static_cast<const uchar*>(m_memory->constData()) + buffer * bufferBytes;
+  m_frame = QImage(
+    data,
+    size.width(),
+    size.height(),
+    bytesPerLine,
+    static_cast<QImage::Format>(format),
+    [](void* memory) { delete static_cast<std::shared_ptr<QSharedMemory>*>(memory); },
+    new std::shared_ptr<QSharedMemory>(m_memory));
+  m_frame.setDevicePixelRatio(m_devicePixelRatio);
+  m_frameBuffer = buffer;
+
+  emit frameReady();
+}
+
+void QVggRemoteContainer::hostFinished()
+{
+  m_watchdog.stop();
+  if (m_socket)
+  {
+    m_socket->deleteLater();
+    m_socket = nullptr;
+  }
+  m_readBuffer.clear();
+  m_pending.clear();
+  m_frameBuffer = -1;
+  // The frame points into shared memory a restarted host may render into.
+  m_frame = m_frame.copy();
+
+  if (m_stopping)
+  {
+    return;
+  }
+  if (++m_restarts > MAX_RESTARTS)
+  {
+    qWarning("QVggRemoteContainer: the host keeps failing, load the document again to retry");
+    return;
+  }
+
+  qWarning("QVggRemoteContainer: the host stopped, restarting it");
+  m_pending = m_resizeMessage + m_loadMessage;
+  startHost();
+}
+
+void QVggRemoteContainer::checkHost()
+{
+  if (m_lastPong.elapsed() > UNRESPONSIVE_MS)
+  {
+    m_responsive = false;
+  }
+  if (m_lastPong.elapsed() > HOST_TIMEOUT_MS)
+  {
+    qWarning("QVggRemoteContainer: the host does not answer");
+    m_process.kill(); // restarted when it finished
+    return;
+  }
+  if (m_socket)
+  {
+    send(QVggRemoteProtocol::message(QVggRemoteProtocol::Ping));
+  }
+}
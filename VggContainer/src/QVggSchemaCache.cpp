@@ -0,0 +1,153 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggSchemaCache.hpp"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+
+namespace
+{
+
+QByteArray hashFile(const QString& filePath)
+{
+  QFile file{ filePath };
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return {};
+  }
+
+  QCryptographicHash hash{ QCryptographicHash::Md5 };
+  if (!hash.addData(&file))
+  {
+    return {};
+  }
+  return hash.result();
+}
+
+} // namespace
+
+QVggSchemaCache& QVggSchemaCache::instance()
+{
+  static QVggSchemaCache s_instance;
+  return s_instance;
+}
+
+QByteArray QVggSchemaCache::documentKey(
+  const QString& filePath,
+  const char*    designDocSchemaFilePath,
+  const char*    layoutDocSchemaFilePath)
+{
+  if ((!designDocSchemaFilePath && !layoutDocSchemaFilePath) || !isFastValidationEnabled())
+  {
+    return {};
+  }
+
+  const auto designSchema = schemaFingerprint(designDocSchemaFilePath);
+  const auto layoutSchema = schemaFingerprint(layoutDocSchemaFilePath);
+  if (
+    (designDocSchemaFilePath && designSchema.isEmpty()) ||
+    (layoutDocSchemaFilePath && layoutSchema.isEmpty()))
+  {
+    return {};
+  }
+
+  const auto document = hashFile(filePath);
+  if (document.isEmpty())
+  {
+    return {};
+  }
+
+  // Hex parts joined by '|', so a design schema can never pass for a layout schema and vice versa.
+  return document.toHex() + '|' + designSchema.toHex() + '|' + layoutSchema.toHex();
+}
+
+bool QVggSchemaCache::isValidated(const QByteArray& key)
+{
+  if (key.isEmpty())
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_validatedDocuments.contains(key);
+}
+
+void QVggSchemaCache::setValidated(const QByteArray& key)
+{
+  if (key.isEmpty())
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_validatedDocuments.insert(key);
+}
+
+void QVggSchemaCache::setFastValidationEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_fastValidationEnabled = enabled;
+}
+
+bool QVggSchemaCache::isFastValidationEnabled()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_fastValidationEnabled;
+}
+
+void QVggSchemaCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_schemas.clear();
+  m_validatedDocuments.clear();
+}
+
+QByteArray QVggSchemaCache::schemaFingerprint(const char* schemaFilePath)
+{
+  if (!schemaFilePath)
+  {
+    return {};
+  }
+
+  const auto      path = QString::fromLocal8Bit(schemaFilePath);
+  const QFileInfo info{ path };
+
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto                        it = m_schemas.constFind(path);
+    if (
+      it != m_schemas.constEnd() && it->lastModified == info.lastModified() &&
+      it->size == info.size())
+    {
+      return it->hash;
+    }
+  }
+
+  SchemaEntry entry;
+  entry.lastModified = info.lastModified();
+  entry.size = info.size();
+  entry.hash = hashFile(path);
+  if (entry.hash.isEmpty())
+  {
+    return {};
+  }
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_schemas.insert(path, entry);
+  return entry.hash;
+}
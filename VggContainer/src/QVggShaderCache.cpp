@@ -0,0 +1,141 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggShaderCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+#include <mutex>
+
+namespace
+{
+
+const QString K_CACHE_DIRECTORY_NAME = QStringLiteral("programs");
+const QString K_DRIVER_FILE_NAME = QStringLiteral("driver");
+const QString K_STALE_FILE_NAME = QStringLiteral("stale");
+
+struct State
+{
+  std::mutex lock;
+  QString    directory;
+  bool       validated{ false };
+};
+
+State& getState()
+{
+  static State s_state;
+  return s_state;
+}
+
+void setEnvironment(const char* name, const QByteArray& value)
+{
+  // Settings made by the user take precedence.
+  if (!qEnvironmentVariableIsSet(name))
+  {
+    qputenv(name, value);
+  }
+}
+
+QByteArray driverKey(QOpenGLContext* context)
+{
+  auto functions = context->functions();
+  auto glString = [functions](GLenum name)
+  { return QByteArray(reinterpret_cast<const char*>(functions->glGetString(name))); };
+
+  QCryptographicHash hash{ QCryptographicHash::Md5 };
+  hash.addData(glString(GL_VENDOR));
+  hash.addData(glString(GL_RENDERER));
+  hash.addData(glString(GL_VERSION));
+  return hash.result().toHex();
+}
+
+} // namespace
+
+void QVggShaderCache::setDirectory(const QString& path)
+{
+  auto&                       state = getState();
+  std::lock_guard<std::mutex> lock(state.lock);
+
+  state.directory = path;
+  state.validated = false;
+  if (path.isEmpty())
+  {
+    return;
+  }
+
+  QDir       directory{ path };
+  const auto cachePath = directory.filePath(K_CACHE_DIRECTORY_NAME);
+  if (QFile::exists(directory.filePath(K_STALE_FILE_NAME)))
+  {
+    QDir{ cachePath }.removeRecursively();
+    QFile::remove(directory.filePath(K_STALE_FILE_NAME));
+  }
+  if (!directory.mkpath(cachePath))
+  {
+    return;
+  }
+
+  const auto nativePath = QDir::toNativeSeparators(cachePath).toLocal8Bit();
+  setEnvironment("MESA_SHADER_CACHE_DIR", nativePath);
+  setEnvironment("MESA_GLSL_CACHE_DIR", nativePath);
+  setEnvironment("__GL_SHADER_DISK_CACHE", "1");
+  setEnvironment("__GL_SHADER_DISK_CACHE_PATH", nativePath);
+  setEnvironment("__GL_SHADER_DISK_CACHE_SKIP_CLEANUP", "1");
+}
+
+void QVggShaderCache::validate(QOpenGLContext* context)
+{
+  auto&                       state = getState();
+  std::lock_guard<std::mutex> lock(state.lock);
+
+  if (state.validated || state.directory.isEmpty() || !context)
+  {
+    return;
+  }
+  state.validated = true;
+
+  QDir       directory{ state.directory };
+  QFile      driverFile{ directory.filePath(K_DRIVER_FILE_NAME) };
+  const auto key = driverKey(context);
+
+  QByteArray lastKey;
+  if (driverFile.open(QIODevice::ReadOnly))
+  {
+    lastKey = driverFile.readAll().trimmed();
+    driverFile.close();
+  }
+  if (key == lastKey)
+  {
+    return;
+  }
+
+  // The cache is in use by the driver now, so it is dropped on the next start. Until then the
+  // driver rejects binaries built by another driver version itself.
+  if (!lastKey.isEmpty())
+  {
+    QFile staleFile{ directory.filePath(K_STALE_FILE_NAME) };
+    staleFile.open(QIODevice::WriteOnly);
+  }
+
+  if (driverFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    driverFile.write(key);
+  }
+}
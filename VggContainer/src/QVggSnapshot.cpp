@@ -0,0 +1,86 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggSnapshot.hpp"
+
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+
+QImage QVggSnapshot::grab(
+  QOpenGLContext*           context,
+  QOpenGLFramebufferObject* source,
+  const QSize&              sourceSize,
+  const QRect&              rect,
+  double                    scale,
+  bool                      bottomUp)
+{
+  const QRect bounds(QPoint(), sourceSize);
+  const auto  area = rect.isEmpty() ? bounds : rect.intersected(bounds);
+  if (area.isEmpty() || scale <= 0)
+  {
+    return {};
+  }
+
+  const auto targetSize = (QSizeF(area.size()) * scale).toSize().expandedTo(QSize(1, 1));
+  const auto sourceRect = bottomUp
+                            ? QRect(
+                                area.x(),
+                                sourceSize.height() - area.y() - area.height(),
+                                area.width(),
+                                area.height())
+                            : area;
+
+  if (QOpenGLFramebufferObject::hasOpenGLFramebufferBlit())
+  {
+    QOpenGLFramebufferObject target(targetSize);
+    QOpenGLFramebufferObject::blitFramebuffer(
+      &target,
+      QRect(QPoint(), targetSize),
+      source,
+      sourceRect,
+      GL_COLOR_BUFFER_BIT,
+      GL_LINEAR);
+    return target.toImage(bottomUp);
+  }
+
+  auto  gl = context->functions();
+  GLint previousFbo = 0;
+  gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+  gl->glBindFramebuffer(
+    GL_FRAMEBUFFER,
+    source ? source->handle() : context->defaultFramebufferObject());
+
+  QImage image(area.size(), QImage::Format_RGBA8888_Premultiplied);
+  gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  gl->glReadPixels(
+    sourceRect.x(),
+    sourceRect.y(),
+    sourceRect.width(),
+    sourceRect.height(),
+    GL_RGBA,
+    GL_UNSIGNED_BYTE,
+    image.bits());
+  gl->glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+
+  if (bottomUp)
+  {
+    image = image.mirrored();
+  }
+  return targetSize == area.size()
+           ? image
+           : image.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
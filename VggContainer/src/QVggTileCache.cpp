@@ -0,0 +1,219 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggTileCache.hpp"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+int floorDiv(int value, int divisor)
+{
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+bool rowsMatch(const uchar* a, const uchar* b, int bytes)
+{
+  // antialiased edges may differ by a rounding step
+  constexpr int TOLERANCE = 2;
+  for (int i = 0; i < bytes; ++i)
+  {
+    if (std::abs(a[i] - b[i]) > TOLERANCE)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+QVggTileCache::QVggTileCache(qint64 memoryCapBytes, int tileSize)
+  : m_memoryCap{ memoryCapBytes }
+  , m_tileSize{ std::max(tileSize, 16) }
+{
+}
+
+void QVggTileCache::setMemoryCap(qint64 bytes)
+{
+  m_memoryCap = bytes;
+  evict();
+}
+
+qint64 QVggTileCache::memoryCap() const
+{
+  return m_memoryCap;
+}
+
+qint64 QVggTileCache::memoryUsage() const
+{
+  return m_memoryUsage;
+}
+
+void QVggTileCache::insert(const QImage& frame, QPoint offset)
+{
+  const QRect frameRect(-offset, frame.size());
+  const auto  range = tileRange(frameRect);
+  for (int row = range.top(); row <= range.bottom(); ++row)
+  {
+    for (int column = range.left(); column <= range.right(); ++column)
+    {
+      const Key  key{ column, row };
+      const auto rect = tileRect(key);
+      const auto area = rect & frameRect;
+
+      auto it = m_tiles.find(key);
+      if (it == m_tiles.end())
+      {
+        Tile tile;
+        tile.image = QImage(rect.size(), frame.format());
+        tile.image.fill(Qt::transparent);
+        m_memoryUsage += tile.image.sizeInBytes();
+        it = m_tiles.emplace(key, std::move(tile)).first;
+      }
+
+      auto&    tile = it->second;
+      QPainter painter(&tile.image);
+      painter.setCompositionMode(QPainter::CompositionMode_Source);
+      painter.drawImage(area.topLeft() - rect.topLeft(), frame, area.translated(offset));
+      painter.end();
+
+      tile.valid += area;
+      tile.lastUse = ++m_useCounter;
+    }
+  }
+  evict();
+}
+
+bool QVggTileCache::covers(QSize size, QPoint offset) const
+{
+  const QRect frameRect(-offset, size);
+  const auto  range = tileRange(frameRect);
+  for (int row = range.top(); row <= range.bottom(); ++row)
+  {
+    for (int column = range.left(); column <= range.right(); ++column)
+    {
+      const Key key{ column, row };
+      auto      it = m_tiles.find(key);
+      if (it == m_tiles.end() || !(QRegion(tileRect(key) & frameRect) - it->second.valid).isEmpty())
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool QVggTileCache::matches(const QImage& frame, QPoint offset) const
+{
+  if (m_tiles.empty())
+  {
+    return true;
+  }
+
+  const auto& tileFormat = m_tiles.begin()->second.image.format();
+  const auto  image = frame.format() == tileFormat ? frame : frame.convertToFormat(tileFormat);
+  const auto  bytesPerPixel = image.depth() / 8;
+
+  const QRect frameRect(-offset, image.size());
+  const auto  range = tileRange(frameRect);
+  for (int row = range.top(); row <= range.bottom(); ++row)
+  {
+    for (int column = range.left(); column <= range.right(); ++column)
+    {
+      const Key key{ column, row };
+      auto      it = m_tiles.find(key);
+      if (it == m_tiles.end())
+      {
+        continue;
+      }
+
+      const auto  origin = tileRect(key).topLeft();
+      const auto& tile = it->second;
+      for (const auto& rect : tile.valid & frameRect)
+      {
+        // rows on a fixed canvas grid, so the same rows are compared however the canvas moved
+        for (int y = (rect.top() + 7) & ~7; y <= rect.bottom(); y += 8)
+        {
+          const auto* cached =
+            tile.image.constScanLine(y - origin.y()) + (rect.left() - origin.x()) * bytesPerPixel;
+          const auto* rendered =
+            image.constScanLine(y + offset.y()) + (rect.left() + offset.x()) * bytesPerPixel;
+          if (!rowsMatch(cached, rendered, rect.width() * bytesPerPixel))
+          {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void QVggTileCache::draw(QPainter& painter, QSize size, QPoint offset)
+{
+  const auto range = tileRange(QRect(-offset, size));
+  for (int row = range.top(); row <= range.bottom(); ++row)
+  {
+    for (int column = range.left(); column <= range.right(); ++column)
+    {
+      const Key key{ column, row };
+      auto      it = m_tiles.find(key);
+      if (it == m_tiles.end())
+      {
+        continue;
+      }
+
+      painter.drawImage(tileRect(key).topLeft() + offset, it->second.image);
+      it->second.lastUse = ++m_useCounter;
+    }
+  }
+}
+
+void QVggTileCache::clear()
+{
+  m_tiles.clear();
+  m_memoryUsage = 0;
+}
+
+QRect QVggTileCache::tileRect(const Key& key) const
+{
+  return QRect(key.first * m_tileSize, key.second * m_tileSize, m_tileSize, m_tileSize);
+}
+
+QRect QVggTileCache::tileRange(const QRect& rect) const
+{
+  return QRect(
+    QPoint(floorDiv(rect.left(), m_tileSize), floorDiv(rect.top(), m_tileSize)),
+    QPoint(floorDiv(rect.right(), m_tileSize), floorDiv(rect.bottom(), m_tileSize)));
+}
+
+void QVggTileCache::evict()
+{
+  while (m_memoryUsage > m_memoryCap && !m_tiles.empty())
+  {
+    auto oldest = std::min_element(
+      m_tiles.begin(),
+      m_tiles.end(),
+      [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+    m_memoryUsage -= oldest->second.image.sizeInBytes();
+    m_tiles.erase(oldest);
+  }
+}
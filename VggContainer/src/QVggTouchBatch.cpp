@@ -0,0 +1,327 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggTouchBatch.hpp"
+
+#include <QNativeGestureEvent>
+#include <QTouchEvent>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// jsButtonIndex + 1 of the left button, as for mouse events.
+constexpr int K_PRIMARY_BUTTON = 1;
+
+constexpr double K_PI = 3.14159265358979323846;
+
+double normalized(double value, double size)
+{
+  return size > 0 ? value / size : 0.0;
+}
+
+} // namespace
+
+bool QVggTouchBatch::add(QTouchEvent* event, const QSizeF& size)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_size = size;
+
+  if (event->type() == QEvent::TouchCancel)
+  {
+    cancelPoints();
+    return true;
+  }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+  for (const auto& qtPoint : event->points())
+  {
+    auto& point = touchPoint(qtPoint.id(), qtPoint.position());
+    point.position = qtPoint.position();
+    point.pressure = qtPoint.pressure();
+    switch (qtPoint.state())
+    {
+      case QEventPoint::State::Pressed:
+        point.pressed = true;
+        break;
+      case QEventPoint::State::Updated:
+        point.moved = true;
+        break;
+      case QEventPoint::State::Released:
+        point.released = true;
+        break;
+      default:
+        break;
+    }
+  }
+#else
+  for (const auto& qtPoint : event->touchPoints())
+  {
+    auto& point = touchPoint(qtPoint.id(), qtPoint.pos());
+    point.position = qtPoint.pos();
+    point.pressure = qtPoint.pressure();
+    switch (qtPoint.state())
+    {
+      case Qt::TouchPointPressed:
+        point.pressed = true;
+        break;
+      case Qt::TouchPointMoved:
+        point.moved = true;
+        break;
+      case Qt::TouchPointReleased:
+        point.released = true;
+        break;
+      default:
+        break;
+    }
+  }
+#endif
+
+  return true;
+}
+
+bool QVggTouchBatch::add(QNativeGestureEvent* event, const QSizeF& size)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_size = size;
+
+  switch (event->gestureType())
+  {
+    case Qt::ZoomNativeGesture:
+      m_gestureScale *= 1.0 + event->value();
+      break;
+    case Qt::RotateNativeGesture:
+      m_gestureRotation += event->value() * K_PI / 180.0;
+      break;
+    default:
+      return false;
+  }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+  m_gestureCenter = event->position();
+#else
+  m_gestureCenter = event->localPos();
+#endif
+  m_hasGesture = true;
+
+  return true;
+}
+
+void QVggTouchBatch::cancel()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  cancelPoints();
+}
+
+void QVggTouchBatch::take(std::vector<UEvent>& events)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  appendPrimaryEvents(events);
+  appendFingerEvents(events);
+  appendGestureEvent(events);
+
+  m_points.erase(
+    std::remove_if(
+      m_points.begin(),
+      m_points.end(),
+      [](const TouchPoint& point) { return point.released; }),
+    m_points.end());
+  for (auto& point : m_points)
+  {
+    point.sentPosition = point.position;
+    point.pressed = false;
+    point.moved = false;
+  }
+}
+
+QVggTouchBatch::TouchPoint& QVggTouchBatch::touchPoint(std::int64_t id, const QPointF& position)
+{
+  auto it = std::find_if(
+    m_points.begin(),
+    m_points.end(),
+    [id](const TouchPoint& point) { return point.id == id && !point.released; });
+  if (it != m_points.end())
+  {
+    return *it;
+  }
+
+  if (m_primaryId < 0)
+  {
+    m_primaryId = id;
+  }
+  m_points.push_back(TouchPoint{ id, position, position, 0.0f, false, false, false, false });
+  return m_points.back();
+}
+
+void QVggTouchBatch::cancelPoints()
+{
+  for (auto& point : m_points)
+  {
+    point.released = true;
+    point.canceled = true;
+  }
+}
+
+void QVggTouchBatch::appendFingerEvents(std::vector<UEvent>& events)
+{
+  for (const auto& point : m_points)
+  {
+    UEvent evt;
+    evt.tfinger.touchId = 0;
+    evt.tfinger.fingerId = point.id;
+    evt.tfinger.pressure = point.pressure;
+
+    if (point.pressed)
+    {
+      evt.tfinger.type = VGG_FINGERDOWN;
+      evt.tfinger.x = normalized(point.sentPosition.x(), m_size.width());
+      evt.tfinger.y = normalized(point.sentPosition.y(), m_size.height());
+      evt.tfinger.dx = 0;
+      evt.tfinger.dy = 0;
+      events.push_back(evt);
+    }
+
+    const auto from = point.sentPosition;
+    if (point.position != from)
+    {
+      evt.tfinger.type = VGG_FINGERMOTION;
+      evt.tfinger.x = normalized(point.position.x(), m_size.width());
+      evt.tfinger.y = normalized(point.position.y(), m_size.height());
+      evt.tfinger.dx = normalized(point.position.x() - from.x(), m_size.width());
+      evt.tfinger.dy = normalized(point.position.y() - from.y(), m_size.height());
+      events.push_back(evt);
+    }
+
+    if (point.released)
+    {
+      evt.tfinger.type = VGG_FINGERUP;
+      evt.tfinger.x = normalized(point.position.x(), m_size.width());
+      evt.tfinger.y = normalized(point.position.y(), m_size.height());
+      evt.tfinger.dx = 0;
+      evt.tfinger.dy = 0;
+      events.push_back(evt);
+    }
+  }
+}
+
+void QVggTouchBatch::appendPrimaryEvents(std::vector<UEvent>& events)
+{
+  auto it = std::find_if(
+    m_points.begin(),
+    m_points.end(),
+    [this](const TouchPoint& point) { return point.id == m_primaryId; });
+  if (it == m_points.end())
+  {
+    return;
+  }
+  const auto& point = *it;
+
+  if (point.pressed && !m_primaryPressed)
+  {
+    UEvent evt;
+    evt.button.type = VGG_MOUSEBUTTONDOWN;
+    evt.button.button = K_PRIMARY_BUTTON;
+    evt.button.windowX = point.sentPosition.x();
+    evt.button.windowY = point.sentPosition.y();
+    events.push_back(evt);
+    m_primaryPressed = true;
+  }
+
+  if (point.position != point.sentPosition)
+  {
+    UEvent evt;
+    evt.motion.type = VGG_MOUSEMOTION;
+    evt.motion.windowX = point.position.x();
+    evt.motion.windowY = point.position.y();
+    evt.motion.xrel = point.position.x() - point.sentPosition.x();
+    evt.motion.yrel = point.position.y() - point.sentPosition.y();
+    events.push_back(evt);
+  }
+
+  if (point.released)
+  {
+    // A canceled touch is not a click.
+    if (m_primaryPressed && !point.canceled)
+    {
+      UEvent evt;
+      evt.button.type = VGG_MOUSEBUTTONUP;
+      evt.button.button = K_PRIMARY_BUTTON;
+      evt.button.windowX = point.position.x();
+      evt.button.windowY = point.position.y();
+      events.push_back(evt);
+    }
+    m_primaryPressed = false;
+    m_primaryId = -1;
+  }
+}
+
+void QVggTouchBatch::appendGestureEvent(std::vector<UEvent>& events)
+{
+  double  scale = m_gestureScale;
+  double  rotation = m_gestureRotation;
+  QPointF center = m_gestureCenter;
+  bool    changed = m_hasGesture;
+
+  // Touchscreens do not send native gestures, derive them from the first two touch points.
+  std::vector<const TouchPoint*> down;
+  for (const auto& point : m_points)
+  {
+    if (!point.released)
+    {
+      down.push_back(&point);
+    }
+  }
+
+  if (down.size() >= 2)
+  {
+    const auto delta = down[1]->position - down[0]->position;
+    const auto spread = std::hypot(delta.x(), delta.y());
+    const auto angle = std::atan2(delta.y(), delta.x());
+    if (down.size() == m_lastPointCount && m_lastSpread > 0)
+    {
+      scale *= spread / m_lastSpread;
+      rotation += std::remainder(angle - m_lastAngle, 2 * K_PI);
+      center = (down[0]->position + down[1]->position) / 2;
+      changed = changed || spread != m_lastSpread || angle != m_lastAngle;
+    }
+    m_lastSpread = spread;
+    m_lastAngle = angle;
+  }
+  m_lastPointCount = down.size();
+
+  m_gestureScale = 1.0;
+  m_gestureRotation = 0.0;
+  m_hasGesture = false;
+
+  if (!changed)
+  {
+    return;
+  }
+
+  // dDist carries the relative change of the spread over the frame, dTheta the rotation in
+  // radians.
+  UEvent evt;
+  evt.mgesture.type = VGG_MULTIGESTURE;
+  evt.mgesture.touchId = 0;
+  evt.mgesture.dDist = scale - 1.0;
+  evt.mgesture.dTheta = rotation;
+  evt.mgesture.x = normalized(center.x(), m_size.width());
+  evt.mgesture.y = normalized(center.y(), m_size.height());
+  evt.mgesture.numFingers = static_cast<std::uint16_t>(std::max<std::size_t>(down.size(), 2));
+  events.push_back(evt);
+}
@@ -14,25 +14,24 @@
  * limitations under the License.
  */
 
-#pragma once
+#include "VggContainer/QVggTransaction.hpp"
 
-#include "VGG/Event.hpp"
-#include "VGG/EventAPI.hpp"
-
-#include <QKeyEvent>
-
-class QVggEventAdapter : public EventAPI
+QVggTransaction::QVggTransaction(std::shared_ptr<QVggDocumentAccess> access)
+  : m_access{ std::move(access) }
 {
-public:
-  static void setup();
-
-  static UEvent keyPressEvent(QKeyEvent* event);
-  static UEvent keyReleaseEvent(QKeyEvent* event);
+  m_access->beginBatch();
+}
 
-  EVGGKeymod getModState() override;
-  uint8_t*   getKeyboardState(int* nums) override;
+QVggTransaction::~QVggTransaction()
+{
+  commit();
+}
 
-private:
-  static EVGGKeymod  toVggModState(Qt::KeyboardModifiers keyboardModifiers);
-  static EVGGKeyCode toVggKeyCode(int key);
-};
+void QVggTransaction::commit()
+{
+  if (m_access)
+  {
+    m_access->commitBatch();
+    m_access.reset();
+  }
+}
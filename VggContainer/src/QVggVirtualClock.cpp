@@ -0,0 +1,48 @@
+/*
+ * Copyright 2023 VeryGoodGraphics LTD <bd@verygoodgraphics.com>
+ *
+ * Licensed under the VGG License, Version 1.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.verygoodgraphics.com/licenses/LICENSE-1.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VggContainer/QVggVirtualClock.hpp"
+
+#include <algorithm>
+
+QVggVirtualClock::QVggVirtualClock(double tickIntervalMs)
+  : m_tickInterval{ std::max(tickIntervalMs, 1.0) }
+  , m_nextTick{ m_tickInterval }
+{
+}
+
+int QVggVirtualClock::advance(double ms)
+{
+  m_elapsed += std::max(ms, 0.0);
+
+  int ticks = 0;
+  while (m_nextTick <= m_elapsed)
+  {
+    m_nextTick += m_tickInterval;
+    ++ticks;
+  }
+  return ticks;
+}
+
+double QVggVirtualClock::elapsed() const
+{
+  return m_elapsed;
+}
+
+double QVggVirtualClock::tickInterval() const
+{
+  return m_tickInterval;
+}
@@ -0,0 +1,122 @@
+#include "QVggOffscreenRenderer.h"
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+#include <QOpenGLFunctions>
+#include <QThread>
+#include <algorithm>
+
+QVggOffscreenRenderer::QVggOffscreenRenderer(double dpi)
+  : m_dpi{ dpi }
+{
+}
+
+QVggOffscreenRenderer::~QVggOffscreenRenderer()
+{
+  release();
+}
+
+bool QVggOffscreenRenderer::create()
+{
+  m_context = std::make_unique<QOpenGLContext>();
+  if (!m_context->create())
+  {
+    m_context.reset();
+    return false;
+  }
+
+  m_surface = std::make_unique<QOffscreenSurface>();
+  m_surface->setFormat(m_context->format());
+  m_surface->create();
+  return m_surface->isValid();
+}
+
+void QVggOffscreenRenderer::moveToThread(QThread* thread)
+{
+  if (m_context)
+  {
+    m_context->moveToThread(thread);
+  }
+}
+
+bool QVggOffscreenRenderer::load(const QString& filePath, const QSize& size)
+{
+  if (!makeCurrent())
+  {
+    return false;
+  }
+
+  m_container.reset();
+  if (!m_fbo || m_size != size)
+  {
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+    m_fbo = std::make_unique<QOpenGLFramebufferObject>(size * m_dpi, format);
+    m_size = size;
+  }
+
+  m_container = std::make_unique<VGG::QtQuickContainer>(
+    std::max(m_size.width(), 1),
+    std::max(m_size.height(), 1),
+    m_dpi,
+    m_fbo->handle());
+  m_container->sdk()->setBackgroundColor(0); // 0 for SK_ColorTRANSPARENT
+
+  const auto path = filePath.toLocal8Bit().toStdString();
+  QVggEnvironment::setUpFor(path);
+  return m_container->load(path);
+}
+
+bool QVggOffscreenRenderer::setCurrentFrame(const std::string& frameId)
+{
+  return m_container && m_container->sdk()->setCurrentFrameById(frameId);
+}
+
+void QVggOffscreenRenderer::dispatch(int count)
+{
+  if (!m_container || !makeCurrent())
+  {
+    return;
+  }
+
+  for (; count > 0; --count)
+  {
+    m_container->dispatch();
+  }
+}
+
+QImage QVggOffscreenRenderer::render()
+{
+  if (!m_container || !makeCurrent())
+  {
+    return {};
+  }
+
+  m_fbo->bind();
+  m_container->paint(true);
+  m_context->functions()->glFlush();
+  m_fbo->bindDefault();
+
+  return m_fbo->toImage(false);
+}
+
+void QVggOffscreenRenderer::release()
+{
+  if (m_context && m_context->thread() == QThread::currentThread())
+  {
+    makeCurrent();
+    m_container.reset();
+    m_fbo.reset();
+    m_context->doneCurrent();
+    m_context.reset();
+  }
+}
+
+bool QVggOffscreenRenderer::makeCurrent()
+{
+  if (!m_context || !m_context->makeCurrent(m_surface.get()))
+  {
+    return false;
+  }
+  QVggShaderCache::validate(m_context.get());
+  return true;
+}
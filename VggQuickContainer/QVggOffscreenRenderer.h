@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSize>
+#include <QString>
+#include "VGG/QtQuickContainer.hpp"
+
+// Renders documents to images without a window. create() makes the surface and the GL context
+// on the GUI thread, everything else runs on the thread the renderer was moved to, so several
+// renderers can work in parallel, each with its own context.
+class QVggOffscreenRenderer
+{
+public:
+  explicit QVggOffscreenRenderer(double dpi = 1.0);
+  ~QVggOffscreenRenderer();
+
+  QVggOffscreenRenderer(const QVggOffscreenRenderer&) = delete;
+  QVggOffscreenRenderer& operator=(const QVggOffscreenRenderer&) = delete;
+
+  // Called on the GUI thread.
+  bool create();
+  void moveToThread(QThread* thread);
+
+  // The size is in logical pixels, images are scaled by the dpi given on construction.
+  bool load(const QString& filePath, const QSize& size);
+  // Shows the frame with the given id, the document opens on its first frame.
+  bool setCurrentFrame(const std::string& frameId);
+  // Runs count dispatch ticks back to back. Only the number of ticks is deterministic, animations
+  // and timers of the runtime follow its own wall clock.
+  void dispatch(int count);
+  // Paints the current frame and reads it back.
+  QImage render();
+
+  // Releases the container and GL resources, called on the rendering thread.
+  void release();
+
+private:
+  bool makeCurrent();
+
+private:
+  std::unique_ptr<QOffscreenSurface>        m_surface;
+  std::unique_ptr<QOpenGLContext>           m_context;
+  std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+  std::unique_ptr<VGG::QtQuickContainer>    m_container;
+  QSize                                     m_size;
+  double                                    m_dpi;
+};
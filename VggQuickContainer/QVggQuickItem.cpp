@@ -1,6 +1,14 @@
-#include "QVggEventAdapter.hpp"
+#include "VggContainer/QVggEventAdapter.hpp"
 #include "QVggQuickItem.h"
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggImageDownsampler.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+#include "VggContainer/QVggSnapshot.hpp"
+#include <QElapsedTimer>
 #include <QGuiApplication>
+#include <QMetaMethod>
+#include <QNativeGestureEvent>
+#include <QTouchEvent>
 
 #ifdef VGG_USE_QT_6
 #define EVENT_POS position
@@ -8,21 +16,37 @@
 #define EVENT_POS pos
 #endif // VGG_USE_QT_6
 
+namespace
+{
+
+// Resolution of the preview frame of progressive rendering, relative to the item.
+constexpr double PREVIEW_SCALE = 0.5;
+
+} // namespace
+
 QVggRenderThread::QVggRenderThread(
   TVggQuickContainer& container,
-  std::mutex&         lock,
+  TVggContainerLock&  lock,
+  TVggEventSink       eventSink,
   QObject*            creator)
   : m_surface(nullptr)
   , m_context(nullptr)
   , m_renderFbo(nullptr)
+  , m_imageDownsampling{ false }
+  , m_progressive{ false }
+  , m_previewPending{ false }
+  , m_refinePending{ false }
   , m_size(1, 1)
   , m_dpi{ 1.0 }
   , m_container(container)
   , m_lock(lock)
+  , m_eventSink(std::move(eventSink))
   , m_needResetContainer{ false }
   , m_sizeChanged{ false }
   , m_needStopped{ false }
   , m_creator(creator)
+  , m_awaitingFirstFrame{ false }
+  , m_virtualTimeMs{ -1.0 }
 {
 }
 
@@ -38,8 +62,12 @@ void QVggRenderThread::InitOpenGLContext(QOpenGLContext* sharedContext)
 {
   assert(!m_context);
   m_context = new QOpenGLContext();
-  m_context->setFormat(sharedContext->format());
-  m_context->setShareContext(sharedContext);
+  // The software scene graph has no context, frames reach it as images only.
+  if (sharedContext)
+  {
+    m_context->setFormat(sharedContext->format());
+    m_context->setShareContext(sharedContext);
+  }
   m_context->create();
 }
 
@@ -60,11 +88,29 @@ QOpenGLFramebufferObject* QVggRenderThread::getFbo()
 
 void QVggRenderThread::setFileSource(QString str)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
+  std::lock_guard<TVggContainerLock> lock(m_lock);
   m_fileSource = str;
   m_needResetContainer = true;
 }
 
+void QVggRenderThread::reload()
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  m_needResetContainer = true;
+}
+
+void QVggRenderThread::setImageDownsampling(bool enabled)
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  m_imageDownsampling = enabled;
+}
+
+void QVggRenderThread::setProgressive(bool enabled)
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  m_progressive = enabled;
+}
+
 void QVggRenderThread::sizeChanged(QSize size)
 {
   if (size == m_size || !size.width() || !size.height())
@@ -72,7 +118,7 @@ void QVggRenderThread::sizeChanged(QSize size)
     return;
   }
 
-  std::lock_guard<std::mutex> lock(m_lock);
+  std::lock_guard<TVggContainerLock> lock(m_lock);
   m_size = size;
   m_sizeChanged = true;
 }
@@ -81,66 +127,263 @@ void QVggRenderThread::renderNext()
 {
   if (!m_needStopped)
   {
-    std::lock_guard<std::mutex> lock(m_lock);
+    std::lock_guard<TVggContainerLock> lock(m_lock);
     m_context->makeCurrent(m_surface);
+    QVggShaderCache::validate(m_context);
 
     if (!m_renderFbo || m_needResetContainer)
+    {
+      resetContainer();
+    }
+    else if (m_sizeChanged && m_renderFbo->size() != m_size)
     {
       QOpenGLFramebufferObjectFormat format;
       format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
       delete m_renderFbo;
       m_renderFbo = new QOpenGLFramebufferObject(m_size, format);
-
-      m_container.reset(new VGG::QtQuickContainer(
-        std::max(m_size.width(), 1),
-        std::max(m_size.height(), 1),
-        m_dpi,
-        m_renderFbo->handle()));
-      // m_container->sdk()->setFitToViewportEnabled(false);
-      m_container->sdk()->setBackgroundColor(0); // 0 for SK_ColorTRANSPARENT
-      m_container->load(m_fileSource.toLocal8Bit().toStdString());
-
-      m_needResetContainer = false;
-      m_sizeChanged = false;
     }
 
-    if (m_sizeChanged)
+    if (m_previewPending)
     {
-      m_container->setFboID(m_renderFbo->handle());
+      renderPreview();
     }
+    else
+    {
+      renderFrame();
+    }
+  }
 
-    m_renderFbo->bind();
+  std::this_thread::sleep_for(std::chrono::milliseconds(16));
+}
+
+// Called with m_lock held and the context current.
+void QVggRenderThread::renderFrame()
+{
+  if (m_sizeChanged)
+  {
+    m_container->setFboID(m_renderFbo->handle());
+  }
 
-    // for transparence
-    // m_context->functions()->glViewport(0, 0, m_size.width(), m_size.height());
-    // m_context->functions()->glEnable(GL_BLEND);
-    // m_context->functions()->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    // m_context->functions()->glClearColor(0, 0, 0, 0);
-    // m_context->functions()->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  m_renderFbo->bind();
 
-    m_container->paint(m_sizeChanged);
+  // for transparence
+  // m_context->functions()->glViewport(0, 0, m_size.width(), m_size.height());
+  // m_context->functions()->glEnable(GL_BLEND);
+  // m_context->functions()->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  // m_context->functions()->glClearColor(0, 0, 0, 0);
+  // m_context->functions()->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // We need to flush the contents to the FBO before posting
-    // the texture to the other thread, otherwise, we might
-    // get unexpected results.
-    m_context->functions()->glFlush();
+  QElapsedTimer paintTimer;
+  paintTimer.start();
 
-    m_renderFbo->bindDefault();
+  m_container->paint(m_sizeChanged || m_refinePending);
 
-    m_sizeChanged = false;
-    emit textureReady(m_renderFbo->toImage(false));
+  // We need to flush the contents to the FBO before posting
+  // the texture to the other thread, otherwise, we might
+  // get unexpected results.
+  m_context->functions()->glFlush();
+
+  if (m_frameExporter)
+  {
+    const double virtualTimeMs = m_virtualTimeMs;
+    m_frameExporter->capture(
+      m_context,
+      m_renderFbo->handle(),
+      m_renderFbo->size(),
+      virtualTimeMs >= 0 ? virtualTimeMs : m_frameExporter->elapsed(),
+      false); // the quick container renders the top row first
   }
+  takeSnapshots();
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(16));
+  if (m_awaitingFirstFrame)
+  {
+    m_awaitingFirstFrame = false;
+    m_loadTimings.finish(paintTimer.nsecsElapsed() / 1e6, m_loadClock.nsecsElapsed() / 1e6);
+  }
+
+  m_renderFbo->bindDefault();
+
+  m_sizeChanged = false;
+  m_refinePending = false;
+  emit textureReady(m_renderFbo->toImage(false));
+}
+
+// Called with m_lock held and the context current. Shows the first frame of a document at a
+// reduced resolution, the next frame refines it at full resolution. Exported frames and snapshots
+// are taken from the refined one.
+void QVggRenderThread::renderPreview()
+{
+  const auto previewSize = (QSizeF(m_size) * PREVIEW_SCALE).toSize().expandedTo(QSize(1, 1));
+
+  QOpenGLFramebufferObjectFormat format;
+  format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  QOpenGLFramebufferObject previewFbo(previewSize, format);
+
+  QElapsedTimer paintTimer;
+  paintTimer.start();
+
+  // The whole item is laid out in the smaller drawable, as at a lower device pixel ratio.
+  previewFbo.bind();
+  m_container->setFboID(previewFbo.handle());
+  resizeDrawable(previewSize);
+  m_container->paint(true);
+  m_context->functions()->glFlush();
+
+  if (m_awaitingFirstFrame)
+  {
+    m_awaitingFirstFrame = false;
+    m_loadTimings.finish(paintTimer.nsecsElapsed() / 1e6, m_loadClock.nsecsElapsed() / 1e6);
+  }
+
+  auto image = previewFbo.toImage(false);
+  image.setDevicePixelRatio(PREVIEW_SCALE);
+
+  m_renderFbo->bind();
+  m_container->setFboID(m_renderFbo->handle());
+  resizeDrawable(m_size);
+  m_renderFbo->bindDefault();
+
+  m_previewPending = false;
+  m_refinePending = true;
+  emit textureReady(image);
+}
+
+// Called with m_lock held and the context current.
+void QVggRenderThread::resizeDrawable(QSize drawableSize)
+{
+  UEvent evt;
+  evt.window.type = VGG_WINDOWEVENT;
+  evt.window.event = VGG_WINDOWEVENT_SIZE_CHANGED;
+  evt.window.data1 = m_size.width();
+  evt.window.data2 = m_size.height();
+  evt.window.drawableWidth = drawableSize.width();
+  evt.window.drawableHeight = drawableSize.height();
+
+  m_container->onEvent(evt);
+}
+
+// Called with m_lock held and the context current.
+void QVggRenderThread::resetContainer()
+{
+  m_loadClock.start();
+  m_awaitingFirstFrame = true;
+  m_loadTimings = {};
+
+  QOpenGLFramebufferObjectFormat format;
+  format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  delete m_renderFbo;
+  m_renderFbo = new QOpenGLFramebufferObject(m_size, format);
+
+  // The quick container creates its GPU backend on construction.
+  QElapsedTimer timer;
+  timer.start();
+  m_container.reset(new VGG::QtQuickContainer(
+    std::max(m_size.width(), 1),
+    std::max(m_size.height(), 1),
+    m_dpi,
+    m_renderFbo->handle()));
+  m_loadTimings.initMs = timer.nsecsElapsed() / 1e6;
+
+  m_container->setEventListener(m_eventSink);
+
+  // m_container->sdk()->setFitToViewportEnabled(false);
+  m_container->sdk()->setBackgroundColor(0); // 0 for SK_ColorTRANSPARENT
+
+  timer.restart();
+  const auto filePath = m_fileSource.toLocal8Bit().toStdString();
+  QVggEnvironment::setUpFor(filePath);
+  m_loadTimings.scriptCheckMs = timer.nsecsElapsed() / 1e6;
+
+  auto loadPath = filePath;
+  if (m_imageDownsampling)
+  {
+    timer.restart();
+    QVggImageDownsampler::Options options;
+    options.devicePixelRatio = m_dpi;
+    loadPath = QVggImageDownsampler::prepare(filePath, options);
+    m_loadTimings.imagePrepareMs = timer.nsecsElapsed() / 1e6;
+  }
+
+  timer.restart();
+  m_container->load(loadPath);
+  m_loadTimings.loadMs = timer.nsecsElapsed() / 1e6;
+
+  m_needResetContainer = false;
+  m_sizeChanged = false;
+  // a refinement of the previous document is dropped
+  m_previewPending = m_progressive;
+  m_refinePending = false;
+  emit documentLoaded();
+}
+
+void QVggRenderThread::requestSnapshot(
+  QRect                                 rect,
+  double                                scale,
+  std::shared_ptr<std::promise<QImage>> promise)
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  m_snapshots.push_back(SnapshotRequest{ rect, scale, std::move(promise) });
+}
+
+// Called with m_lock held, the context current and the frame in m_renderFbo.
+void QVggRenderThread::takeSnapshots()
+{
+  for (auto& request : m_snapshots)
+  {
+    const auto rect = QRectF(
+                        request.rect.x() * m_dpi,
+                        request.rect.y() * m_dpi,
+                        request.rect.width() * m_dpi,
+                        request.rect.height() * m_dpi)
+                        .toAlignedRect();
+    auto image = QVggSnapshot::grab(
+      m_context,
+      m_renderFbo,
+      m_renderFbo->size(),
+      rect,
+      request.scale,
+      false); // the quick container renders the top row first
+    request.promise->set_value(image);
+    emit snapshotReady(image);
+  }
+  m_snapshots.clear();
+}
+
+void QVggRenderThread::setVirtualTime(double ms)
+{
+  m_virtualTimeMs = ms;
+}
+
+void QVggRenderThread::setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter)
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  // Nothing was captured before the context belongs to this thread.
+  if (m_frameExporter && m_context && m_context->thread() == QThread::currentThread())
+  {
+    m_context->makeCurrent(m_surface);
+    m_frameExporter->finish(m_context);
+  }
+  m_frameExporter = std::move(exporter);
+}
+
+QVggLoadTimings QVggRenderThread::loadTimings()
+{
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  return m_loadTimings;
 }
 
 void QVggRenderThread::shutDown()
 {
-  std::lock_guard<std::mutex> lock(m_lock);
+  std::lock_guard<TVggContainerLock> lock(m_lock);
   m_needStopped = true;
   m_container.reset(nullptr);
 
   m_context->makeCurrent(m_surface);
+  if (m_frameExporter)
+  {
+    m_frameExporter->finish(m_context);
+    m_frameExporter.reset();
+  }
   delete m_renderFbo;
   m_context->doneCurrent();
   delete m_context;
@@ -189,7 +432,8 @@ void QVggTextureNode::prepareNode()
     m_texture = m_window->createTextureFromImage(m_image, QQuickWindow::TextureHasAlphaChannel);
     markDirty(DirtyMaterial);
     this->setTexture(m_texture);
-    this->setRect(QRectF(0, 0, m_image.width(), m_image.height()));
+    // previews are scaled up to the size of the item
+    this->setRect(QRectF(QPointF(0, 0), QSizeF(m_image.size()) / m_image.devicePixelRatio()));
 
     // This will notify the rendering thread that the texture is now being rendered
     // and it can start rendering to the other one.
@@ -199,13 +443,68 @@ void QVggTextureNode::prepareNode()
 
 QVggQuickItem::QVggQuickItem(QQuickItem* parent)
   : QQuickItem(parent)
+  , m_imageDownsampling{ false }
+  , m_progressive{ false }
+  , m_eventRouter{ std::make_shared<QVggEventRouter>() }
+  , m_listenerSubscription{ 0 }
+  , m_deliveryScheduled{ false }
 {
   // By default, QQuickItem does not draw anything. If you subclass
   // QQuickItem to create a visual item, you will need to uncomment the
   // following line and re-implement updatePaintNode()
   setFlag(ItemHasContents, true);
 
-  m_renderThread = new QVggRenderThread(m_container, m_lock, this);
+  m_renderThread = new QVggRenderThread(
+    m_container,
+    m_lock,
+    [this](std::string type, std::string targetId, std::string targetPath)
+    { queueEvent(std::move(type), std::move(targetId), std::move(targetPath)); },
+    this);
+
+  // With the dispatch thread, updates are applied by its next tick instead of waiting for the
+  // container lock on the GUI thread.
+  m_documentAccess = std::make_shared<QVggDocumentAccess>(QVggDocumentAccess::Forwarder{
+    [this](const std::string& id)
+    {
+      std::lock_guard<TVggContainerLock> lock(m_lock);
+      return m_container ? m_container->sdk()->getElement(id) : std::string();
+    },
+    [this](const QVggDocumentAccess::Forwarder::Updates& updates)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_postedUpdatesLock);
+        m_postedUpdates.insert(m_postedUpdates.end(), updates.begin(), updates.end());
+      }
+      if (m_dispatcher)
+      {
+        m_dispatcher->wake();
+        return;
+      }
+
+      std::lock_guard<TVggContainerLock> lock(m_lock);
+      applyPostedUpdates();
+    } });
+  m_modelBinding = new QVggModelBinding(m_documentAccess, this);
+
+  // Element handles of the previous container are stale.
+  QObject::connect(
+    m_renderThread,
+    &QVggRenderThread::documentLoaded,
+    this,
+    [this]()
+    {
+      m_elements.clear();
+      m_documentAccess->resetBatch();
+      m_modelBinding->refresh();
+    },
+    Qt::QueuedConnection);
+
+  QObject::connect(
+    m_renderThread,
+    &QVggRenderThread::snapshotReady,
+    this,
+    &QVggQuickItem::snapshotReady,
+    Qt::QueuedConnection);
 
   QObject::connect(
     this,
@@ -213,31 +512,36 @@ QVggQuickItem::QVggQuickItem(QQuickItem* parent)
     m_renderThread,
     &QVggRenderThread::setFileSource,
     Qt::QueuedConnection);
+  QObject::connect(
+    this,
+    &QVggQuickItem::imageDownsamplingChanged,
+    m_renderThread,
+    &QVggRenderThread::setImageDownsampling,
+    Qt::QueuedConnection);
+  QObject::connect(
+    this,
+    &QVggQuickItem::progressiveChanged,
+    m_renderThread,
+    &QVggRenderThread::setProgressive,
+    Qt::QueuedConnection);
 
   auto emitSizeChange = [this]()
   {
     auto w = std::max(static_cast<int>(width()), 1);
     auto h = std::max(static_cast<int>(height()), 1);
 
-    {
-      std::lock_guard<std::mutex> lock(m_lock);
+    // TODO
+    auto scale = 1.0; // m_api->windowHandle()->devicePixelRatio();
 
-      if (m_container)
-      {
-        // TODO
-        auto scale = 1.0; // m_api->windowHandle()->devicePixelRatio();
-
-        UEvent evt;
-        evt.window.type = VGG_WINDOWEVENT;
-        evt.window.event = VGG_WINDOWEVENT_SIZE_CHANGED;
-        evt.window.data1 = w;
-        evt.window.data2 = h;
-        evt.window.drawableWidth = w * scale;
-        evt.window.drawableHeight = h * scale;
-
-        m_container->onEvent(evt);
-      }
-    }
+    // handed to the dispatch thread like input when it is enabled
+    UEvent evt;
+    evt.window.type = VGG_WINDOWEVENT;
+    evt.window.event = VGG_WINDOWEVENT_SIZE_CHANGED;
+    evt.window.data1 = w;
+    evt.window.data2 = h;
+    evt.window.drawableWidth = w * scale;
+    evt.window.drawableHeight = h * scale;
+    sendEvent(evt);
 
     emit sizeChanged(QSize(w, h));
   };
@@ -253,6 +557,7 @@ QVggQuickItem::QVggQuickItem(QQuickItem* parent)
 
   this->setAcceptedMouseButtons(Qt::MouseButton::AllButtons);
   this->setAcceptHoverEvents(true);
+  this->setAcceptTouchEvents(true);
 
   m_dispatchTimer.setInterval(16);
   QObject::connect(
@@ -261,19 +566,18 @@ QVggQuickItem::QVggQuickItem(QQuickItem* parent)
     this,
     [this]()
     {
-      std::lock_guard<std::mutex> lock(m_lock);
-
-      if (!m_container)
+      if (!m_dispatcher)
       {
-        return;
+        dispatch();
       }
-      m_container->dispatch(); // todo, improve dispatch
     });
   m_dispatchTimer.start();
 }
 
 QVggQuickItem::~QVggQuickItem()
 {
+  m_dispatcher.reset();
+  m_documentAccess->detach();
   QMetaObject::invokeMethod(m_renderThread, "shutDown", Qt::QueuedConnection);
   m_renderThread->wait();
   assert(!m_container);
@@ -316,31 +620,333 @@ void QVggQuickItem::setFileSource(const QString& src)
   }
 
   m_fileSource = src;
+  m_elements.clear();
+  if (m_watcher)
+  {
+    m_watcher->watch(m_fileSource);
+  }
   emit fileSourceChanged(m_fileSource);
 }
 
-void QVggQuickItem::setEventListener(QVggQuickItem::EventListener listener)
+bool QVggQuickItem::imageDownsampling() const
 {
-  std::lock_guard<std::mutex> lock(m_lock);
+  return m_imageDownsampling;
+}
 
-  if (!m_container)
+void QVggQuickItem::setImageDownsampling(bool enabled)
+{
+  if (enabled == m_imageDownsampling)
   {
     return;
   }
 
-  if (listener)
+  m_imageDownsampling = enabled;
+  emit imageDownsamplingChanged(m_imageDownsampling);
+}
+
+bool QVggQuickItem::progressive() const
+{
+  return m_progressive;
+}
+
+void QVggQuickItem::setProgressive(bool enabled)
+{
+  if (enabled == m_progressive)
+  {
+    return;
+  }
+
+  m_progressive = enabled;
+  emit progressiveChanged(m_progressive);
+}
+
+bool QVggQuickItem::dispatchThread() const
+{
+  return m_dispatcher != nullptr;
+}
+
+void QVggQuickItem::setDispatchThread(bool enabled)
+{
+  if (enabled == dispatchThread() || (enabled && m_virtualClock))
+  {
+    return;
+  }
+
+  if (enabled)
+  {
+    m_dispatcher.reset(new QVggDispatcher([this]() { dispatch(); }));
+  }
+  else
+  {
+    m_dispatcher.reset();
+    dispatch();
+  }
+  emit dispatchThreadChanged(enabled);
+}
+
+double QVggQuickItem::dispatchBudget() const
+{
+  return m_dispatchQueue.budget();
+}
+
+void QVggQuickItem::setDispatchBudget(double budgetMs)
+{
+  if (budgetMs == m_dispatchQueue.budget())
+  {
+    return;
+  }
+
+  m_dispatchQueue.setBudget(budgetMs);
+  // queued input goes first, before input is applied directly under the new budget
+  if (!m_dispatcher && !m_virtualClock)
+  {
+    std::lock_guard<TVggContainerLock> lock(m_lock);
+    if (m_container)
+    {
+      QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+      m_dispatchQueue.drain([this](UEvent& evt) { applyEvent(evt); });
+    }
+  }
+  emit dispatchBudgetChanged(m_dispatchQueue.budget());
+}
+
+bool QVggQuickItem::virtualClock() const
+{
+  return m_virtualClock != nullptr;
+}
+
+void QVggQuickItem::setVirtualClock(bool enabled)
+{
+  if (enabled == virtualClock())
+  {
+    return;
+  }
+
+  if (enabled)
+  {
+    m_dispatchTimer.stop();
+    setDispatchThread(false);
+    m_virtualClock = std::make_unique<QVggVirtualClock>(m_dispatchTimer.interval());
+    m_renderThread->setVirtualTime(m_virtualClock->elapsed());
+  }
+  else
+  {
+    m_virtualClock.reset();
+    m_renderThread->setVirtualTime(-1.0);
+    m_dispatchTimer.start();
+  }
+  m_dispatchQueue.setBudgetSuspended(enabled);
+  emit virtualClockChanged(enabled);
+}
+
+void QVggQuickItem::advance(double ms)
+{
+  if (!m_virtualClock)
+  {
+    return;
+  }
+
+  for (auto ticks = m_virtualClock->advance(ms); ticks > 0; --ticks)
   {
-    auto sdk = m_container->sdk();
-    m_container->setEventListener(
-      [listener, sdk](std::string type, std::string targetId, std::string targetPath)
-      { listener(sdk, type, targetId, targetPath); });
+    dispatch();
+  }
+  m_renderThread->setVirtualTime(m_virtualClock->elapsed());
+}
+
+std::future<QImage> QVggQuickItem::snapshot(const QRect& rect, double scale)
+{
+  auto promise = std::make_shared<std::promise<QImage>>();
+  auto future = promise->get_future();
+  QMetaObject::invokeMethod(
+    m_renderThread,
+    [renderThread = m_renderThread, rect, scale, promise]()
+    { renderThread->requestSnapshot(rect, scale, promise); },
+    Qt::QueuedConnection);
+  return future;
+}
+
+void QVggQuickItem::setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter)
+{
+  QMetaObject::invokeMethod(
+    m_renderThread,
+    [renderThread = m_renderThread, exporter = std::move(exporter)]() mutable
+    { renderThread->setFrameExporter(std::move(exporter)); },
+    Qt::QueuedConnection);
+}
+
+QVggDispatchStats QVggQuickItem::dispatchStats() const
+{
+  return m_dispatchQueue.stats(m_eventQueue);
+}
+
+bool QVggQuickItem::watch() const
+{
+  return m_watcher != nullptr;
+}
+
+void QVggQuickItem::setWatch(bool enabled)
+{
+  if (enabled == watch())
+  {
+    return;
+  }
+
+  if (enabled)
+  {
+    m_watcher.reset(new QVggDocumentWatcher(
+      [this](const QVggDocumentWatcher::Change& change) { applyDocumentChange(change); }));
+    if (!m_fileSource.isEmpty())
+    {
+      m_watcher->watch(m_fileSource);
+    }
   }
   else
   {
-    m_container->setEventListener(nullptr);
+    m_watcher.reset();
+  }
+  emit watchChanged(enabled);
+}
+
+void QVggQuickItem::applyDocumentChange(const QVggDocumentWatcher::Change& change)
+{
+  if (change.needsReload)
+  {
+    m_elements.clear();
+    QMetaObject::invokeMethod(m_renderThread, &QVggRenderThread::reload, Qt::QueuedConnection);
+    return;
+  }
+
+  QVggTransaction transaction(m_documentAccess);
+  for (const auto& [id, patch] : change.elementPatches)
+  {
+    m_documentAccess->updateElement(id, patch);
+  }
+}
+
+QVggLoadTimings QVggQuickItem::loadTimings() const
+{
+  return m_renderThread->loadTimings();
+}
+
+void QVggQuickItem::setEventListener(QVggQuickItem::EventListener listener)
+{
+  if (m_listenerSubscription)
+  {
+    m_eventRouter->unsubscribe(m_listenerSubscription);
+    m_listenerSubscription = 0;
+  }
+
+  if (listener)
+  {
+    m_listenerSubscription = m_eventRouter->subscribe(
+      {},
+      {},
+      [this, listener](const QVggEvent& event)
+      {
+        std::lock_guard<TVggContainerLock> lock(m_lock);
+        if (m_container)
+        {
+          listener(m_container->sdk(), event.type, event.targetId, event.targetPath);
+        }
+      });
+  }
+}
+
+// Called under the container lock, on whichever thread the runtime raises the event.
+void QVggQuickItem::queueEvent(std::string type, std::string targetId, std::string targetPath)
+{
+  m_eventQueue.push({ std::move(type), std::move(targetId), std::move(targetPath) });
+  if (!m_deliveryScheduled.exchange(true))
+  {
+    QMetaObject::invokeMethod(this, [this]() { deliverEvents(); }, Qt::QueuedConnection);
+  }
+}
+
+void QVggQuickItem::deliverEvents()
+{
+  m_deliveryScheduled = false;
+
+  const auto signal = QMetaMethod::fromSignal(&QVggQuickItem::vggEvent);
+  const auto emitSignal = isSignalConnected(signal);
+
+  const auto done = m_dispatchQueue.deliver(
+    m_eventQueue,
+    [this, emitSignal](QVggEventQueue::Event& event)
+    {
+      m_eventRouter->route(event.type, event.targetId, event.targetPath);
+      if (emitSignal)
+      {
+        emit vggEvent(
+          QString::fromStdString(event.type),
+          QString::fromStdString(event.targetId),
+          QString::fromStdString(event.targetPath));
+      }
+    });
+  if (!done && !m_deliveryScheduled.exchange(true))
+  {
+    // the rest after the pending frame
+    QMetaObject::invokeMethod(this, [this]() { deliverEvents(); }, Qt::QueuedConnection);
   }
 }
 
+int QVggQuickItem::subscribe(
+  const std::string& type,
+  const std::string& target,
+  EventHandler       handler)
+{
+  return m_eventRouter->subscribe(type, target, std::move(handler));
+}
+
+void QVggQuickItem::unsubscribe(int subscription)
+{
+  m_eventRouter->unsubscribe(subscription);
+}
+
+QVggElement QVggQuickItem::element(const std::string& id)
+{
+  return QVggElement(m_documentAccess, id);
+}
+
+QVggTransaction QVggQuickItem::transaction()
+{
+  return QVggTransaction(m_documentAccess);
+}
+
+QVggModelBinding* QVggQuickItem::modelBinding() const
+{
+  return m_modelBinding;
+}
+
+void QVggQuickItem::beginUpdate()
+{
+  m_documentAccess->beginBatch();
+}
+
+void QVggQuickItem::endUpdate()
+{
+  m_documentAccess->commitBatch();
+}
+
+QVariant QVggQuickItem::elementValue(const QString& id, const QString& path)
+{
+  return cachedElement(id).value(path).toVariant();
+}
+
+bool QVggQuickItem::setElementValue(const QString& id, const QString& path, const QVariant& value)
+{
+  return cachedElement(id).setValue(path, QJsonValue::fromVariant(value));
+}
+
+QVggElement& QVggQuickItem::cachedElement(const QString& id)
+{
+  auto it = m_elements.find(id);
+  if (it == m_elements.end())
+  {
+    it = m_elements.insert(id, element(id.toStdString()));
+  }
+  return *it;
+}
+
 void QVggQuickItem::fillVggEvent(UEvent& vggEvent, QMouseEvent* mouseEvent)
 {
   switch (mouseEvent->button())
@@ -365,57 +971,102 @@ void QVggQuickItem::fillVggEvent(UEvent& vggEvent, QMouseEvent* mouseEvent)
   vggEvent.button.windowY = p.y();
 }
 
-void QVggQuickItem::keyPressEvent(QKeyEvent* event)
+void QVggQuickItem::sendEvent(const UEvent& evt)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
-
-  if (!m_container)
+  if (m_dispatcher)
+  {
+    m_dispatchQueue.post(evt);
+    m_dispatcher->wake();
+    return;
+  }
+  // queued behind earlier input, otherwise applied right away even with a budget
+  if (m_virtualClock || !m_dispatchQueue.isEmpty())
   {
+    m_dispatchQueue.post(evt);
     return;
   }
 
-  auto vggEvent = QVggEventAdapter::keyPressEvent(event);
-  m_container->onEvent(vggEvent);
+  std::lock_guard<TVggContainerLock> lock(m_lock);
+  if (m_container)
+  {
+    UEvent event = evt;
+    applyEvent(event);
+  }
 }
 
-void QVggQuickItem::keyReleaseEvent(QKeyEvent* event)
+void QVggQuickItem::applyEvent(UEvent& evt)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
+  m_keyboardState.apply(evt);
+  QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+  m_container->onEvent(evt);
+}
 
+void QVggQuickItem::applyTouchEvents()
+{
+  m_touchEvents.clear();
+  m_touchBatch.take(m_touchEvents);
+  for (auto& evt : m_touchEvents)
+  {
+    applyEvent(evt);
+  }
+}
+
+// Called with the container lock held.
+void QVggQuickItem::applyPostedUpdates()
+{
+  QVggDocumentAccess::Forwarder::Updates updates;
+  {
+    std::lock_guard<std::mutex> lock(m_postedUpdatesLock);
+    updates.swap(m_postedUpdates);
+  }
   if (!m_container)
   {
     return;
   }
-
-  auto vggEvent = QVggEventAdapter::keyReleaseEvent(event);
-  m_container->onEvent(vggEvent);
+  for (const auto& [id, patch] : updates)
+  {
+    m_container->sdk()->updateElement(id, patch);
+  }
 }
 
-void QVggQuickItem::mousePressEvent(QMouseEvent* event)
+void QVggQuickItem::dispatch()
 {
-  std::lock_guard<std::mutex> lock(m_lock);
-
+  std::lock_guard<TVggContainerLock> lock(m_lock);
   if (!m_container)
   {
     return;
   }
+  QVggKeyboardState::Scope keyboardScope(m_keyboardState);
+  applyPostedUpdates();
+  applyTouchEvents();
+  m_dispatchQueue.run(
+    [this](UEvent& evt) { applyEvent(evt); },
+    [this]() { m_container->dispatch(); }); // todo, improve dispatch
+}
+
+void QVggQuickItem::keyPressEvent(QKeyEvent* event)
+{
+  auto vggEvent = QVggEventAdapter::keyPressEvent(event);
+  sendEvent(vggEvent);
+}
+
+void QVggQuickItem::keyReleaseEvent(QKeyEvent* event)
+{
+  auto vggEvent = QVggEventAdapter::keyReleaseEvent(event);
+  sendEvent(vggEvent);
+}
 
+void QVggQuickItem::mousePressEvent(QMouseEvent* event)
+{
   UEvent evt;
   evt.button.type = VGG_MOUSEBUTTONDOWN;
   fillVggEvent(evt, event);
 
-  m_container->onEvent(evt);
+  sendEvent(evt);
 }
 
 void QVggQuickItem::mouseMoveEvent(QMouseEvent* event)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
-
-  if (!m_container)
-  {
-    return;
-  }
-
   UEvent evt;
   evt.motion.type = VGG_MOUSEMOTION;
   evt.motion.windowX = event->EVENT_POS().x();
@@ -425,7 +1076,7 @@ void QVggQuickItem::mouseMoveEvent(QMouseEvent* event)
   evt.motion.xrel = delta.x();
   evt.motion.yrel = delta.y();
 
-  m_container->onEvent(evt);
+  sendEvent(evt);
 
   m_lastMouseMovePosition = event->EVENT_POS();
 }
@@ -440,29 +1091,43 @@ void QVggQuickItem::hoverMoveEvent(QHoverEvent* event)
 
 void QVggQuickItem::mouseReleaseEvent(QMouseEvent* event)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
-
-  if (!m_container)
-  {
-    return;
-  }
-
   UEvent evt;
   evt.button.type = VGG_MOUSEBUTTONUP;
   fillVggEvent(evt, event);
 
-  m_container->onEvent(evt);
+  sendEvent(evt);
 }
 
-void QVggQuickItem::wheelEvent(QWheelEvent* event)
+void QVggQuickItem::touchEvent(QTouchEvent* event)
 {
-  std::lock_guard<std::mutex> lock(m_lock);
-
-  if (!m_container)
+  if (m_touchBatch.add(event, size()))
   {
+    event->accept();
     return;
   }
+  QQuickItem::touchEvent(event);
+}
+
+void QVggQuickItem::touchUngrabEvent()
+{
+  m_touchBatch.cancel();
+  QQuickItem::touchUngrabEvent();
+}
+
+bool QVggQuickItem::event(QEvent* event)
+{
+  if (
+    event->type() == QEvent::NativeGesture &&
+    m_touchBatch.add(static_cast<QNativeGestureEvent*>(event), size()))
+  {
+    event->accept();
+    return true;
+  }
+  return QQuickItem::event(event);
+}
 
+void QVggQuickItem::wheelEvent(QWheelEvent* event)
+{
   UEvent evt;
   evt.wheel.type = VGG_MOUSEWHEEL;
 
@@ -476,7 +1141,7 @@ void QVggQuickItem::wheelEvent(QWheelEvent* event)
   evt.wheel.preciseX = delta.x();
   evt.wheel.preciseY = delta.y();
 
-  m_container->onEvent(evt);
+  sendEvent(evt);
 }
 
 QSGNode* QVggQuickItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* updatePaintNodeData)
@@ -493,12 +1158,18 @@ QSGNode* QVggQuickItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* u
     // Some GL implementations requres that the currently bound m_context is
     // made non-current before we set up sharing, so we doneCurrent here
     // and makeCurrent down below while setting up our own m_context.
-    current->doneCurrent();
+    if (current)
+    {
+      current->doneCurrent();
+    }
 
     m_renderThread->InitOpenGLContext(current);
     m_renderThread->getOpenGLContext()->moveToThread(m_renderThread);
 
-    current->makeCurrent(window());
+    if (current)
+    {
+      current->makeCurrent(window());
+    }
 
     QMetaObject::invokeMethod(this, "ready");
     return nullptr;
@@ -551,20 +1222,8 @@ QSGNode* QVggQuickItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* u
     QMetaObject::invokeMethod(m_renderThread, "renderNext", Qt::QueuedConnection);
   }
 
-  if (width() > 0 && height() > 0 && QOpenGLContext::currentContext())
-  {
-    std::lock_guard<std::mutex> lock(m_lock);
-
-    QOpenGLFramebufferObjectFormat format;
-    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-
-    if (m_renderThread->getFbo())
-    {
-      delete m_renderThread->getFbo();
-    }
-
-    m_renderThread->setFbo(new QOpenGLFramebufferObject(QSize(width(), height()), format));
-  }
+  // The render thread recreates its framebuffer when the size changed, with its own context, so
+  // this works with the software scene graph too.
 
   // node->setRect(boundingRect());
   return node;
@@ -1,5 +1,6 @@
 #pragma once
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <QTimer>
@@ -11,16 +12,41 @@
 #include <QOffscreenSurface>
 #include <QSGSimpleTextureNode>
 #include <QOpenGLFramebufferObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <future>
 #include "VGG/QtQuickContainer.hpp"
+#include "VggContainer/QVggDispatchQueue.hpp"
+#include "VggContainer/QVggDispatcher.hpp"
+#include "VggContainer/QVggDocumentWatcher.hpp"
+#include "VggContainer/QVggElement.hpp"
+#include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggEventQueue.hpp"
+#include "VggContainer/QVggEventRouter.hpp"
+#include "VggContainer/QVggFrameExporter.hpp"
+#include "VggContainer/QVggLoadTimings.hpp"
+#include "VggContainer/QVggModelBinding.hpp"
+#include "VggContainer/QVggTouchBatch.hpp"
+#include "VggContainer/QVggTransaction.hpp"
+#include "VggContainer/QVggVirtualClock.hpp"
 
 typedef std::unique_ptr<VGG::QtQuickContainer> TVggQuickContainer;
+// Recursive since event listeners run under the lock and may access elements.
+typedef std::recursive_mutex TVggContainerLock;
+// Receives the events of the container, called under the container lock.
+typedef std::function<void(std::string type, std::string targetId, std::string targetPath)>
+  TVggEventSink;
 
 class QVggRenderThread : public QThread
 {
   Q_OBJECT
 
 public:
-  QVggRenderThread(TVggQuickContainer& container, std::mutex& lock, QObject* creator);
+  QVggRenderThread(
+    TVggQuickContainer& container,
+    TVggContainerLock&  lock,
+    TVggEventSink       eventSink,
+    QObject*            creator);
 
 public:
   void InitOffScreenSurface();
@@ -30,28 +56,69 @@ public:
   void                      setFbo(QOpenGLFramebufferObject* fbo);
   QOpenGLFramebufferObject* getFbo();
 
+  QVggLoadTimings loadTimings();
+
+  // Called on the render thread, flushes the previous exporter.
+  void setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter);
+  // Timestamps exported frames with the virtual clock, negative for the exporter's clock. Thread
+  // safe.
+  void setVirtualTime(double ms);
+  // Called on the render thread, the snapshot is taken from the next frame.
+  void requestSnapshot(QRect rect, double scale, std::shared_ptr<std::promise<QImage>> promise);
+
 public slots:
   void setFileSource(QString str);
+  // Loads the current file again into a new container.
+  void reload();
+  void setImageDownsampling(bool enabled);
+  void setProgressive(bool enabled);
   void sizeChanged(QSize size);
   void renderNext();
   void shutDown();
 
 signals:
   void textureReady(QImage image);
+  void documentLoaded();
+  void snapshotReady(QImage image);
+
+private:
+  void resetContainer();
+  void renderFrame();
+  void renderPreview();
+  void resizeDrawable(QSize drawableSize);
+  void takeSnapshots();
+
+  struct SnapshotRequest
+  {
+    QRect                                 rect;
+    double                                scale;
+    std::shared_ptr<std::promise<QImage>> promise;
+  };
 
 private:
-  QOffscreenSurface*        m_surface;
-  QOpenGLContext*           m_context;
-  QOpenGLFramebufferObject* m_renderFbo;
-  QString                   m_fileSource;
-  QSize                     m_size;
-  double                    m_dpi;
-  TVggQuickContainer&       m_container;
-  std::mutex&               m_lock;
-  bool                      m_needResetContainer;
-  bool                      m_sizeChanged;
-  bool                      m_needStopped;
-  QObject*                  m_creator;
+  QOffscreenSurface*                 m_surface;
+  QOpenGLContext*                    m_context;
+  QOpenGLFramebufferObject*          m_renderFbo;
+  QString                            m_fileSource;
+  bool                               m_imageDownsampling;
+  bool                               m_progressive;
+  bool                               m_previewPending;
+  bool                               m_refinePending;
+  QSize                              m_size;
+  double                             m_dpi;
+  TVggQuickContainer&                m_container;
+  TVggContainerLock&                 m_lock;
+  TVggEventSink                      m_eventSink;
+  bool                               m_needResetContainer;
+  bool                               m_sizeChanged;
+  bool                               m_needStopped;
+  QObject*                           m_creator;
+  QVggLoadTimings                    m_loadTimings;
+  QElapsedTimer                      m_loadClock;
+  bool                               m_awaitingFirstFrame;
+  std::shared_ptr<QVggFrameExporter> m_frameExporter;
+  std::atomic<double>                m_virtualTimeMs;
+  std::vector<SnapshotRequest>       m_snapshots;
 };
 
 class QVggTextureNode
@@ -87,6 +154,21 @@ class QVggQuickItem : public QQuickItem
 {
   Q_OBJECT
   Q_PROPERTY(QString fileSource READ fileSource WRITE setFileSource NOTIFY fileSourceChanged)
+  Q_PROPERTY(bool imageDownsampling READ imageDownsampling WRITE setImageDownsampling NOTIFY
+               imageDownsamplingChanged)
+  Q_PROPERTY(bool watch READ watch WRITE setWatch NOTIFY watchChanged)
+  // Shows the first frame of a document at half resolution, refined at full resolution by the
+  // next frame, so heavy documents appear sooner.
+  Q_PROPERTY(bool progressive READ progressive WRITE setProgressive NOTIFY progressiveChanged)
+  // Runs scripts and event dispatch on their own thread instead of the GUI thread.
+  Q_PROPERTY(bool dispatchThread READ dispatchThread WRITE setDispatchThread NOTIFY
+               dispatchThreadChanged)
+  // Limits the time a dispatch tick spends on queued input and event handlers, in milliseconds.
+  Q_PROPERTY(double dispatchBudget READ dispatchBudget WRITE setDispatchBudget NOTIFY
+               dispatchBudgetChanged)
+  // Stops the 16 ms dispatch timer, ticks then only run with advance().
+  Q_PROPERTY(bool virtualClock READ virtualClock WRITE setVirtualClock NOTIFY virtualClockChanged)
+  Q_PROPERTY(QVggModelBinding* modelBinding READ modelBinding CONSTANT)
 
 public:
   explicit QVggQuickItem(QQuickItem* parent = nullptr);
@@ -98,15 +180,91 @@ public:
     std::string                type,
     std::string                targetId,
     std::string                targetPath)>;
+  using EventHandler = QVggEventRouter::Handler;
 
 public:
   QString fileSource() const;
   void    setFileSource(const QString& src);
+  bool    imageDownsampling() const;
+  void    setImageDownsampling(bool enabled);
+  bool    progressive() const;
+  void    setProgressive(bool enabled);
+  bool    dispatchThread() const;
+  void    setDispatchThread(bool enabled);
+  double  dispatchBudget() const;
+  void    setDispatchBudget(double budgetMs);
+  bool    virtualClock() const;
+  void    setVirtualClock(bool enabled);
+  bool    watch() const;
+  void    setWatch(bool enabled);
+  // Receives every event under the container lock, prefer subscribe() or the vggEvent signal.
   void    setEventListener(EventListener listener);
   void    fillVggEvent(UEvent& vggEvent, QMouseEvent* mouseEvent);
 
+  // Calls the handler for events of the type, e.g. "mouseup", whose target id or path matches the
+  // target, e.g. "#counterButton" or "#counterButton*". Empty type or target match anything.
+  // Events are queued and handled on the GUI thread without the container lock, so handlers do
+  // not stall rendering. Returns the subscription for unsubscribe().
+  int  subscribe(const std::string& type, const std::string& target, EventHandler handler);
+  void unsubscribe(int subscription);
+
+  // Handle to the element with the given id, e.g. "#counterButton". Keep it to access the
+  // element repeatedly, call QVggElement::refresh() after the document is reloaded.
+  QVggElement element(const std::string& id);
+
+  // Element updates made while the returned transaction is alive are applied together.
+  QVggTransaction transaction();
+
+  // Value of an element property addressed by a JSON pointer, e.g. "/style/fills/0/color/alpha".
+  // Handles are cached per id until the file source changes.
+  Q_INVOKABLE QVariant elementValue(const QString& id, const QString& path);
+  Q_INVOKABLE bool     setElementValue(
+    const QString&  id,
+    const QString&  path,
+    const QVariant& value);
+
+  // Binds models and object properties to elements of the document, see QVggModelBinding.
+  QVggModelBinding* modelBinding() const;
+
+  // QML counterpart of transaction(), every beginUpdate() needs a matching endUpdate(). Updates
+  // left open are dropped when a document is loaded.
+  Q_INVOKABLE void beginUpdate();
+  Q_INVOKABLE void endUpdate();
+
+  // Timings of the last load up to its first frame, complete once that frame is painted.
+  // Enable the "vgg.load" logging category at info level to log them.
+  QVggLoadTimings loadTimings() const;
+
+  // Runs the dispatch ticks falling into the interval back to back, with the virtual clock. Input
+  // is applied at the next tick, the dispatch thread and budget are not used meanwhile.
+  Q_INVOKABLE void advance(double ms);
+
+  // Streams the frames of the render thread to the exporter, timestamped by the virtual clock when
+  // enabled, otherwise since the creation of the exporter. Virtual timestamps match the content
+  // only for changes made by dispatch ticks, e.g. scripts reacting to input. Animations of the
+  // runtime follow its wall clock regardless, record them without the virtual clock.
+  // Frames in flight are flushed when the exporter is replaced, nullptr stops the export.
+  void setFrameExporter(std::shared_ptr<QVggFrameExporter> exporter);
+
+  // Copies rect, in item coordinates and empty for the whole item, from the next frame of the
+  // render thread, scaled by scale, e.g. 0.25 for a thumbnail. The future is fulfilled and
+  // snapshotReady() emitted once the frame is rendered.
+  std::future<QImage> snapshot(const QRect& rect = QRect(), double scale = 1.0);
+
+  // Queue depths and budget overruns of the dispatch ticks.
+  Q_INVOKABLE QVggDispatchStats dispatchStats() const;
+
 signals:
   void fileSourceChanged(QString newFileSource);
+  void imageDownsamplingChanged(bool enabled);
+  void progressiveChanged(bool enabled);
+  void watchChanged(bool enabled);
+  void dispatchThreadChanged(bool enabled);
+  void dispatchBudgetChanged(double budgetMs);
+  void virtualClockChanged(bool enabled);
+  // Emitted on the GUI thread for every event of the document, after the subscriptions.
+  void vggEvent(QString type, QString targetId, QString targetPath);
+  void snapshotReady(QImage image);
   void sizeChanged(QSize size);
 
 public Q_SLOTS:
@@ -121,12 +279,53 @@ protected:
   virtual void     keyReleaseEvent(QKeyEvent* event) override;
   virtual void     mousePressEvent(QMouseEvent* event) override;
   virtual void     wheelEvent(QWheelEvent* event) override;
+  // Touch points and native pinch/rotate gestures are batched and sent once per frame.
+  void             touchEvent(QTouchEvent* event) override;
+  void             touchUngrabEvent() override;
+  bool             event(QEvent* event) override;
+
+private:
+  void         applyDocumentChange(const QVggDocumentWatcher::Change& change);
+  QVggElement& cachedElement(const QString& id);
+  void         queueEvent(std::string type, std::string targetId, std::string targetPath);
+  void         deliverEvents();
+  void         sendEvent(const UEvent& evt);
+  // Called with the container lock held.
+  void         applyEvent(UEvent& evt);
+  void         applyTouchEvents();
+  void         applyPostedUpdates();
+  void         dispatch();
 
 private:
   QString            m_fileSource;
+  bool               m_imageDownsampling;
+  bool               m_progressive;
   TVggQuickContainer m_container;
-  std::mutex         m_lock;
+  TVggContainerLock  m_lock;
   QTimer             m_dispatchTimer;
   QPointF            m_lastMouseMovePosition;
   QVggRenderThread*  m_renderThread;
+
+  std::unique_ptr<QVggDocumentWatcher> m_watcher;
+
+  std::shared_ptr<QVggDocumentAccess> m_documentAccess;
+  QHash<QString, QVggElement>         m_elements;
+  QVggModelBinding*                   m_modelBinding;
+
+  std::shared_ptr<QVggEventRouter> m_eventRouter;
+  int                              m_listenerSubscription;
+  QVggEventQueue                   m_eventQueue;
+  std::atomic_bool                 m_deliveryScheduled;
+
+  // With the dispatch thread, input is handed over to it, so the GUI thread never waits for a
+  // running script.
+  // Element updates are handed over as well, reads still wait for the container lock.
+  std::unique_ptr<QVggDispatcher>        m_dispatcher;
+  std::mutex                             m_postedUpdatesLock;
+  QVggDocumentAccess::Forwarder::Updates m_postedUpdates;
+  QVggDispatchQueue                      m_dispatchQueue;
+  std::unique_ptr<QVggVirtualClock>      m_virtualClock;
+  QVggKeyboardState                      m_keyboardState;
+  QVggTouchBatch                         m_touchBatch;
+  std::vector<UEvent>                    m_touchEvents;
 };
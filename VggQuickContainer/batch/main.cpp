@@ -0,0 +1,263 @@
+#include "VggContainer/QVggEventAdapter.hpp"
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+#include "QVggOffscreenRenderer.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QHash>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Renders frames of .daruma files to PNG or raw RGBA without a display, e.g.
+//   QT_QPA_PLATFORM=offscreen VggBatchRender -o previews --size 1280x800 *.daruma
+// Every worker owns a GL context and renders whole files, so a software GL scales with the cores.
+
+namespace
+{
+struct Options
+{
+  QDir        outputDir;
+  QSize       size{ 1920, 1080 };
+  double      scale{ 1.0 };
+  bool        rawRgba{ false };
+  int         ticks{ 0 };
+  QStringList frames;
+};
+
+// Names outputs after the documents and numbers documents sharing a name, so none overwrite others.
+QStringList outputNames(const QStringList& files)
+{
+  QStringList         names;
+  QHash<QString, int> counts;
+  for (const auto& file : files)
+  {
+    names << QFileInfo(file).completeBaseName();
+    ++counts[names.back()];
+  }
+
+  QHash<QString, int> numbers;
+  for (auto& name : names)
+  {
+    if (counts.value(name) > 1)
+    {
+      name += QString("-%1").arg(++numbers[name]);
+    }
+  }
+  return names;
+}
+
+QString outputPath(const Options& options, const QString& documentName, const QString& frame)
+{
+  auto name = documentName;
+  if (!frame.isEmpty())
+  {
+    name += '-' + QString(frame).replace('/', '_').replace('#', "");
+  }
+  if (options.rawRgba)
+  {
+    return options.outputDir.filePath(
+      QString("%1-%2x%3.rgba")
+        .arg(name)
+        .arg(qRound(options.size.width() * options.scale))
+        .arg(qRound(options.size.height() * options.scale)));
+  }
+  return options.outputDir.filePath(name + ".png");
+}
+
+bool write(const Options& options, const QImage& image, const QString& path)
+{
+  if (!options.rawRgba)
+  {
+    return image.save(path, "PNG");
+  }
+
+  const auto rgba = image.convertToFormat(QImage::Format_RGBA8888);
+  QFile      file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  for (int y = 0; y < rgba.height(); ++y)
+  {
+    const auto line = reinterpret_cast<const char*>(rgba.constScanLine(y));
+    if (file.write(line, rgba.width() * 4) != rgba.width() * 4)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the number of outputs that failed.
+int renderFile(
+  QVggOffscreenRenderer& renderer,
+  const Options&         options,
+  const QString&         file,
+  const QString&         name)
+{
+  if (!renderer.load(file, options.size))
+  {
+    qWarning().noquote() << "failed to load" << file;
+    return 1;
+  }
+
+  if (options.frames.isEmpty())
+  {
+    renderer.dispatch(options.ticks);
+    const auto path = outputPath(options, name, {});
+    return write(options, renderer.render(), path) ? 0 : 1;
+  }
+
+  int failures = 0;
+  for (const auto& frame : options.frames)
+  {
+    const auto path = outputPath(options, name, frame);
+    const auto shown = renderer.setCurrentFrame(frame.toStdString());
+    if (shown)
+    {
+      renderer.dispatch(options.ticks);
+    }
+    if (!shown || !write(options, renderer.render(), path))
+    {
+      qWarning().noquote() << "failed to render" << frame << "of" << file;
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  // llvmpipe starts rasterizer threads per context, the workers already use every core.
+  if (!qEnvironmentVariableIsSet("LP_NUM_THREADS"))
+  {
+    qputenv("LP_NUM_THREADS", "1");
+  }
+
+  QVggEventAdapter::setup();
+  QGuiApplication::setApplicationName("VggBatchRender");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Renders frames of .daruma files to images.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("files", "Documents to render.", "<file>...");
+  parser.addOptions({
+    { { "o", "output" }, "Output directory.", "dir", "." },
+    { "size", "Viewport size in logical pixels.", "WxH", "1920x1080" },
+    { "scale", "Device pixel ratio.", "ratio", "1" },
+    { "frame", "Id of a frame to render, repeatable. Defaults to the first frame.", "id" },
+    { "format", "png or rgba (raw 8-bit RGBA rows).", "format", "png" },
+    { "ticks", "Dispatch ticks run before each frame is rendered.", "count", "0" },
+    { { "j", "jobs" }, "Number of workers, defaults to the number of cores.", "count" },
+    { "shader-cache", "Directory to keep compiled shaders in.", "dir" },
+  });
+
+  // The shader cache is set up before the application, which may load the GL driver. Errors are
+  // reported by process() below.
+  QStringList arguments;
+  for (int i = 0; i < argc; ++i)
+  {
+    arguments.append(QString::fromLocal8Bit(argv[i]));
+  }
+  if (parser.parse(arguments) && parser.isSet("shader-cache"))
+  {
+    QVggShaderCache::setDirectory(parser.value("shader-cache"));
+  }
+
+  QGuiApplication app(argc, argv);
+  parser.process(app);
+
+  Options options;
+  options.outputDir = QDir(parser.value("output"));
+  options.frames = parser.values("frame");
+  options.rawRgba = parser.value("format") == "rgba";
+  options.scale = parser.value("scale").toDouble();
+  options.ticks = parser.value("ticks").toInt();
+
+  const auto size = parser.value("size").split('x');
+  if (size.size() == 2)
+  {
+    options.size = QSize(size[0].toInt(), size[1].toInt());
+  }
+
+  const auto files = parser.positionalArguments();
+  if (files.isEmpty() || options.size.isEmpty() || options.scale <= 0)
+  {
+    parser.showHelp(1);
+  }
+  if (!options.outputDir.mkpath("."))
+  {
+    qCritical().noquote() << "cannot create" << options.outputDir.path();
+    return 1;
+  }
+  const auto names = outputNames(files);
+  auto       workerCount = parser.isSet("jobs") ? parser.value("jobs").toInt()
+                                          : QThread::idealThreadCount();
+  workerCount = std::clamp(workerCount, 1, static_cast<int>(files.size()));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Surfaces and contexts are created on the GUI thread, then each context moves to its worker.
+  std::vector<std::unique_ptr<QVggOffscreenRenderer>> renderers;
+  std::vector<std::unique_ptr<QThread>>               workers;
+  std::atomic<int>                                    nextFile{ 0 };
+  std::atomic<int>                                    failures{ 0 };
+
+  for (int i = 0; i < workerCount; ++i)
+  {
+    auto renderer = std::make_unique<QVggOffscreenRenderer>(options.scale);
+    if (!renderer->create())
+    {
+      qCritical() << "cannot create an OpenGL context";
+      return 1;
+    }
+
+    auto rendererPtr = renderer.get();
+    auto worker = std::unique_ptr<QThread>(QThread::create(
+      [rendererPtr, &options, &files, &names, &nextFile, &failures]()
+      {
+        for (auto i = nextFile++; i < files.size(); i = nextFile++)
+        {
+          failures += renderFile(*rendererPtr, options, files[i], names[i]);
+        }
+        rendererPtr->release();
+      }));
+    renderer->moveToThread(worker.get());
+
+    renderers.push_back(std::move(renderer));
+    workers.push_back(std::move(worker));
+  }
+
+  for (auto& worker : workers)
+  {
+    worker->start();
+  }
+  for (auto& worker : workers)
+  {
+    worker->wait();
+  }
+
+  qInfo().noquote() << QString("rendered %1 files with %2 workers in %3 s, %4 failed")
+                         .arg(files.size())
+                         .arg(workerCount)
+                         .arg(timer.elapsed() / 1000.0)
+                         .arg(failures.load());
+
+  renderers.clear();
+  QVggEnvironment::tearDown();
+  return failures ? 1 : 0;
+}
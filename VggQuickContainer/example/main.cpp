@@ -1,15 +1,22 @@
-#include "VGG/Environment.hpp"
-#include "QVggEventAdapter.hpp"
+#include "VggContainer/QVggEnvironment.hpp"
+#include "VggContainer/QVggShaderCache.hpp"
+#include "VggContainer/QVggEventAdapter.hpp"
 #include "QVggQuickItem.h"
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQuickWindow>
+#include <QStandardPaths>
 
 int main(int argc, char* argv[])
 {
-  VGG::Environment::setUp();
+  // The JavaScript environment is started by the first loaded document that contains scripts.
   QVggEventAdapter::setup();
 
+  // before the application, which may load the GL driver
+  QGuiApplication::setApplicationName("VggQtQuickDemo");
+  QVggShaderCache::setDirectory(
+    QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/vgg/shaders");
+
   QGuiApplication app(argc, argv);
   qmlRegisterType<QVggQuickItem>("QVggQuickItem", 1, 0, "QVggQuickItem");
 
@@ -17,7 +24,7 @@ int main(int argc, char* argv[])
   QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
 #endif // VGG_USE_QT_6
 
-  QObject::connect(&app, &QGuiApplication::aboutToQuit, [&]() { VGG::Environment::tearDown(); });
+  QObject::connect(&app, &QGuiApplication::aboutToQuit, [&]() { QVggEnvironment::tearDown(); });
 
   QQmlApplicationEngine engine;
   const QUrl            url("qrc:/main.qml");